@@ -0,0 +1,199 @@
+// implements AsyncScorer class
+#include "AsyncScorer.hpp"
+
+#include <chrono>
+
+namespace vader
+{
+	AsyncScorer::AsyncScorer(SentimentIntensityAnalyzer &analyzer, int threads, size_t queue_capacity, int batch_size)
+		: m_analyzer(analyzer), m_batch_size(std::max(batch_size, 1)), m_queue(queue_capacity), m_accepting(true), m_running(true),
+		  m_submitting(0), m_sleeping(0), m_blocked(0), m_submitted(0), m_rejected(0), m_completed(0), m_failed(0), m_batches(0)
+	{
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		for (int i = 0; i < threads; i++)
+			this->m_workers.push_back(std::thread(&AsyncScorer::_work, this));
+	}
+
+	AsyncScorer::~AsyncScorer()
+	{
+		this->shutdown();
+	}
+
+	bool AsyncScorer::try_submit(String text, std::function<void(const Sentiment &)> callback, std::function<void(std::exception_ptr)> on_error)
+	{
+		Job job { std::move(text), std::move(callback), std::move(on_error) };
+		if (this->_push(job))
+			return true;
+		this->m_rejected.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	bool AsyncScorer::try_submit(String text, std::future<Sentiment> &result)
+	{
+		std::shared_ptr<std::promise<Sentiment>> promise = std::make_shared<std::promise<Sentiment>>();
+		std::future<Sentiment> future = promise->get_future();
+		if (!this->try_submit(std::move(text), [promise](const Sentiment &vs) { promise->set_value(vs); },
+				[promise](std::exception_ptr error) { promise->set_exception(error); }))
+			return false;
+		result = std::move(future);
+		return true;
+	}
+
+	std::future<Sentiment> AsyncScorer::submit(String text)
+	{
+		std::shared_ptr<std::promise<Sentiment>> promise = std::make_shared<std::promise<Sentiment>>();
+		std::future<Sentiment> future = promise->get_future();
+		Job job { std::move(text), [promise](const Sentiment &vs) { promise->set_value(vs); },
+			[promise](std::exception_ptr error) { promise->set_exception(error); } };
+		while (!this->_push(job))
+		{
+			// pairs with the fence in _work: either this sees the room a worker made, or the worker sees this waiting
+			std::unique_lock<std::mutex> guard(this->m_room_lock);
+			this->m_blocked.fetch_add(1);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (this->m_accepting.load() && this->m_queue.size_approx() >= this->m_queue.capacity())
+				this->m_room.wait_for(guard, std::chrono::milliseconds(10));
+			this->m_blocked.fetch_sub(1);
+			if (!this->m_accepting.load())
+				return std::future<Sentiment>();
+		}
+		return future;
+	}
+
+	size_t AsyncScorer::pending()
+	{
+		return this->m_queue.size_approx();
+	}
+
+	size_t AsyncScorer::capacity()
+	{
+		return this->m_queue.capacity();
+	}
+
+	AsyncScorerStats AsyncScorer::get_stats()
+	{
+		AsyncScorerStats stats;
+		stats.submitted = this->m_submitted.load(std::memory_order_relaxed);
+		stats.rejected = this->m_rejected.load(std::memory_order_relaxed);
+		stats.completed = this->m_completed.load(std::memory_order_relaxed);
+		stats.failed = this->m_failed.load(std::memory_order_relaxed);
+		stats.batches = this->m_batches.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void AsyncScorer::shutdown()
+	{
+		// Once no submit is between its m_accepting check and its push, every job that will ever be queued is in the
+		// queue, and the workers stop when they find it empty
+		if (!this->m_accepting.exchange(false))
+			return;
+		{
+			std::lock_guard<std::mutex> guard(this->m_room_lock);
+			this->m_room.notify_all();
+		}
+		while (this->m_submitting.load() > 0)
+			std::this_thread::yield();
+		{
+			std::lock_guard<std::mutex> guard(this->m_idle_lock);
+			this->m_running = false;
+			this->m_idle.notify_all();
+		}
+		for (std::thread &worker : this->m_workers)
+			worker.join();
+		this->m_workers.clear();
+	}
+
+	bool AsyncScorer::_push(Job &job)
+	{
+		this->m_submitting.fetch_add(1);
+		bool pushed = this->m_accepting.load() && this->m_queue.try_push(job);
+		this->m_submitting.fetch_sub(1);
+		if (!pushed)
+			return false;
+		this->m_submitted.fetch_add(1, std::memory_order_relaxed);
+
+		// pairs with the fence in _work: either the worker going to sleep sees this job, or this sees the worker
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (this->m_sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> guard(this->m_idle_lock);
+			this->m_idle.notify_one();
+		}
+		return true;
+	}
+
+	void AsyncScorer::_work()
+	{
+		// Takes up to m_batch_size jobs off the queue at a time, so the queue's shared positions are touched once per
+		// job but the worker goes back to the queue (and to sleep) once per batch
+		const int spins = 64; // empty polls before sleeping
+		if (this->m_analyzer.get_tracer())
+			this->m_analyzer.get_tracer()->set_thread_name("async scorer worker");
+		std::vector<Job> batch;
+		batch.reserve(this->m_batch_size);
+		int empty_polls = 0;
+		while (true)
+		{
+			bool stopping = !this->m_running.load(); // read before polling: a stopping worker has seen every push
+			Job job;
+			while (batch.size() < (size_t)this->m_batch_size && this->m_queue.try_pop(job))
+				batch.push_back(std::move(job));
+
+			if (batch.empty())
+			{
+				if (stopping)
+					return;
+				if (++empty_polls < spins)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				TraceSpan idle(this->m_analyzer.get_tracer(), "idle");
+				std::unique_lock<std::mutex> guard(this->m_idle_lock);
+				this->m_sleeping.fetch_add(1);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (this->m_running.load() && this->m_queue.size_approx() == 0)
+					this->m_idle.wait_for(guard, std::chrono::milliseconds(10));
+				this->m_sleeping.fetch_sub(1);
+				continue;
+			}
+
+			empty_polls = 0;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (this->m_blocked.load() > 0)
+			{
+				std::lock_guard<std::mutex> guard(this->m_room_lock);
+				this->m_room.notify_all();
+			}
+
+			// an exception must not leave the worker thread (that would terminate the process): it goes to the job
+			this->m_batches.fetch_add(1, std::memory_order_relaxed);
+			TraceSpan span(this->m_analyzer.get_tracer(), "batch");
+			for (Job &done : batch)
+			{
+				try
+				{
+					Sentiment vs = this->m_analyzer.polarity_scores(done.text);
+					done.done(vs);
+					this->m_completed.fetch_add(1, std::memory_order_relaxed);
+				}
+				catch (...)
+				{
+					this->m_failed.fetch_add(1, std::memory_order_relaxed);
+					if (done.failed)
+					{
+						try
+						{
+							done.failed(std::current_exception());
+						}
+						catch (...)
+						{
+						}
+					}
+				}
+			}
+			batch.clear();
+		}
+	}
+}
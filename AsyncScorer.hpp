@@ -0,0 +1,168 @@
+// vader::AsyncScorer class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    template <class T>
+    class BoundedQueue // Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's array queue)
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence; // == position: free for the push at position, == position + 1: holds its value
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_push_position; // own cache lines, so producers and consumers do not share one
+        alignas(64) std::atomic<size_t> m_pop_position;
+
+    public:
+        BoundedQueue(size_t capacity) // rounded up to a power of two, at least 2
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+            this->m_cells.reset(new Cell[size]);
+            for (size_t i = 0; i < size; i++)
+                this->m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            this->m_mask = size - 1;
+            this->m_push_position.store(0, std::memory_order_relaxed);
+            this->m_pop_position.store(0, std::memory_order_relaxed);
+        }
+
+        bool try_push(T &value) // moves value in and returns true, or returns false (value untouched) if the queue is full
+        {
+            Cell *cell;
+            size_t position = this->m_push_position.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell = &this->m_cells[position & this->m_mask];
+                long long difference = (long long)cell->sequence.load(std::memory_order_acquire) - (long long)position;
+                if (difference == 0)
+                {
+                    if (this->m_push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                    return false;
+                else
+                    position = this->m_push_position.load(std::memory_order_relaxed);
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T &value) // false if the queue is empty
+        {
+            Cell *cell;
+            size_t position = this->m_pop_position.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell = &this->m_cells[position & this->m_mask];
+                long long difference = (long long)cell->sequence.load(std::memory_order_acquire) - (long long)(position + 1);
+                if (difference == 0)
+                {
+                    if (this->m_pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                    return false;
+                else
+                    position = this->m_pop_position.load(std::memory_order_relaxed);
+            }
+            value = std::move(cell->value);
+            cell->sequence.store(position + this->m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const
+        {
+            return this->m_mask + 1;
+        }
+
+        size_t size_approx() const // exact when no push or pop is in progress
+        {
+            size_t pushed = this->m_push_position.load();
+            size_t popped = this->m_pop_position.load();
+            return pushed > popped ? pushed - popped : 0;
+        }
+    };
+
+    struct AsyncScorerStats
+    {
+        unsigned long long submitted = 0;
+        unsigned long long rejected = 0; // try_submit calls turned away because the queue was full (or shut down)
+        unsigned long long completed = 0;
+        unsigned long long failed = 0; // scoring or the callback threw
+        unsigned long long batches = 0; // drained by the workers, completed / batches is the mean batch size
+    };
+
+    class AsyncScorer // Scores texts on a pool of worker threads, fed through a bounded lock-free queue.
+    {
+    private:
+        struct Job
+        {
+            String text;
+            std::function<void(const Sentiment &)> done;
+            std::function<void(std::exception_ptr)> failed; // may be empty
+        };
+
+        SentimentIntensityAnalyzer &m_analyzer;
+        int m_batch_size;
+        BoundedQueue<Job> m_queue;
+        std::vector<std::thread> m_workers;
+
+        std::atomic<bool> m_accepting;
+        std::atomic<bool> m_running;
+        std::atomic<int> m_submitting; // submit calls past the m_accepting check, so shutdown can wait for their push
+        std::atomic<int> m_sleeping; // idle workers waiting on m_idle, producers only take m_idle_lock when there are some
+        std::mutex m_idle_lock;
+        std::condition_variable m_idle;
+        std::atomic<int> m_blocked; // submit calls waiting on m_room for the queue to have room, workers only take m_room_lock when there are some
+        std::mutex m_room_lock;
+        std::condition_variable m_room;
+
+        std::atomic<unsigned long long> m_submitted;
+        std::atomic<unsigned long long> m_rejected;
+        std::atomic<unsigned long long> m_completed;
+        std::atomic<unsigned long long> m_failed;
+        std::atomic<unsigned long long> m_batches;
+
+    public:
+        // threads: 0 for one per core, batch_size: most jobs a worker takes off the queue at once
+        AsyncScorer(SentimentIntensityAnalyzer &analyzer, int threads=0, size_t queue_capacity=1024, int batch_size=16);
+        ~AsyncScorer(); // shutdown()
+
+        // Non-blocking, for event loops: false if the queue is full (backpressure) or shut down. The callbacks run on a
+        // worker thread; on_error gets what scoring or callback threw (without it, that is only counted as failed).
+        bool try_submit(String text, std::function<void(const Sentiment &)> callback, std::function<void(std::exception_ptr)> on_error=nullptr);
+        bool try_submit(String text, std::future<Sentiment> &result); // the future rethrows what scoring threw
+        // Blocking: waits for room in the queue. Returns an invalid future after shutdown.
+        std::future<Sentiment> submit(String text);
+
+        size_t pending(); // queued, not yet taken by a worker
+        size_t capacity();
+        AsyncScorerStats get_stats();
+        void shutdown(); // stops accepting texts, scores everything already queued and joins the workers
+
+    private:
+        bool _push(Job &job);
+        void _work();
+    };
+}
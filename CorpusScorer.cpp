@@ -0,0 +1,312 @@
+// implements CorpusScorer class
+#include "CorpusScorer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vader
+{
+	CorpusScorer::CorpusScorer(SentimentIntensityAnalyzer &analyzer, int threads, size_t chunk_size, int checkpoint_interval)
+		: m_analyzer(analyzer), m_threads(threads), m_chunk_size(chunk_size), m_checkpoint_interval(checkpoint_interval),
+		  m_progress_stream(nullptr), m_progress_interval(5.0)
+	{
+		if (this->m_threads <= 0)
+			this->m_threads = std::max(1u, std::thread::hardware_concurrency());
+		if (this->m_chunk_size == 0)
+			this->m_chunk_size = 1;
+		if (this->m_checkpoint_interval <= 0)
+			this->m_checkpoint_interval = 1;
+	}
+
+	CorpusScorer::~CorpusScorer()
+	{
+	}
+
+	void CorpusScorer::set_progress_stream(std::ostream *progress_stream, double interval_seconds)
+	{
+		this->m_progress_stream = progress_stream;
+		this->m_progress_interval = interval_seconds;
+	}
+
+	CorpusProgress CorpusScorer::get_progress()
+	{
+		return this->m_progress;
+	}
+
+	std::string CorpusScorer::get_error()
+	{
+		return this->m_error;
+	}
+
+	bool CorpusScorer::score_file(std::string input_file, std::string output_file)
+	{
+		// Worker threads take newline aligned chunks of the mapped input in order and score them into their own
+		// buffers; the calling thread writes the buffers out in input order. Every m_checkpoint_interval chunks the
+		// output is flushed to disk and the input offset, line count and output size reached are written to the
+		// checkpoint file, which a later run uses to truncate the output and continue from there.
+		this->m_progress = CorpusProgress();
+		this->m_error.clear();
+		std::string checkpoint_file = output_file + ".checkpoint";
+
+		int in_fd = open(input_file.c_str(), O_RDONLY);
+		struct stat in_stat;
+		if (in_fd < 0 || fstat(in_fd, &in_stat) != 0)
+		{
+			this->m_error = "cannot open " + input_file;
+			if (in_fd >= 0)
+				close(in_fd);
+			return false;
+		}
+		size_t input_size = in_stat.st_size;
+		const char *data = nullptr;
+		if (input_size > 0)
+		{
+			void *mapped = mmap(nullptr, input_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+			if (mapped == MAP_FAILED)
+			{
+				this->m_error = "cannot map " + input_file;
+				close(in_fd);
+				return false;
+			}
+			madvise(mapped, input_size, MADV_SEQUENTIAL);
+			data = (const char *)mapped;
+		}
+		close(in_fd); // the mapping stays valid
+
+		// resume from the checkpoint if it was written for this input (same size, modification time, inode and first
+		// 64 KiB) and chunk size, and the output has all it says
+		CorpusInput input;
+		input.size = input_size;
+		input.modified = in_stat.st_mtime;
+		input.inode = in_stat.st_ino;
+		input.head_hash = _hash(data, std::min<size_t>(input_size, 1 << 16));
+		size_t input_offset = 0, output_offset = 0;
+		unsigned long long lines = 0;
+		{
+			std::ifstream checkpoint(checkpoint_file);
+			std::string magic;
+			int version = 0;
+			CorpusInput checkpoint_input;
+			size_t checkpoint_chunk_size = 0;
+			struct stat out_stat;
+			if (!(checkpoint >> magic >> version >> checkpoint_input.size >> checkpoint_input.modified >> checkpoint_input.inode >> checkpoint_input.head_hash
+					>> checkpoint_chunk_size >> input_offset >> lines >> output_offset)
+				|| magic != "vader-checkpoint" || version != 2 || checkpoint_input.size != input.size || checkpoint_input.modified != input.modified
+				|| checkpoint_input.inode != input.inode || checkpoint_input.head_hash != input.head_hash || checkpoint_chunk_size != this->m_chunk_size
+				|| input_offset > input_size || stat(output_file.c_str(), &out_stat) != 0 || (size_t)out_stat.st_size < output_offset)
+			{
+				input_offset = 0;
+				output_offset = 0;
+				lines = 0;
+			}
+		}
+		int out_fd = open(output_file.c_str(), O_WRONLY | O_CREAT, 0644);
+		if (out_fd < 0 || ftruncate(out_fd, output_offset) != 0 || lseek(out_fd, output_offset, SEEK_SET) < 0)
+		{
+			this->m_error = "cannot open " + output_file;
+			if (out_fd >= 0)
+				close(out_fd);
+			if (data)
+				munmap((void *)data, input_size);
+			return false;
+		}
+
+		struct Chunk
+		{
+			size_t end;
+			std::string out;
+			unsigned long long lines = 0;
+		};
+		std::mutex lock;
+		std::condition_variable changed;
+		size_t next_offset = input_offset;
+		long long next_chunk = 0, written_chunks = 0;
+		long long max_in_flight = 2 * this->m_threads; // bounds the memory held by chunks waiting to be written
+		std::map<long long, Chunk> done;
+		std::atomic<bool> failed(false);
+
+		std::vector<std::thread> workers;
+		for (int t = 0; t < this->m_threads; t++)
+		{
+			workers.push_back(std::thread([&]() {
+				Tracer *tracer = this->m_analyzer.get_tracer();
+				if (tracer)
+					tracer->set_thread_name("corpus scorer worker");
+				while (true)
+				{
+					Chunk chunk;
+					size_t begin;
+					long long i;
+					{
+						TraceSpan wait(tracer, "wait for chunk"); // long waits: the writer is behind (max_in_flight chunks)
+						std::unique_lock<std::mutex> guard(lock);
+						changed.wait(guard, [&]() { return failed || next_offset >= input_size || next_chunk - written_chunks < max_in_flight; });
+						if (failed || next_offset >= input_size)
+							return;
+						begin = next_offset;
+						chunk.end = std::min(begin + this->m_chunk_size, input_size);
+						if (chunk.end < input_size)
+						{
+							const char *newline = (const char *)std::memchr(data + chunk.end, '\n', input_size - chunk.end);
+							chunk.end = newline ? newline - data + 1 : input_size;
+						}
+						next_offset = chunk.end;
+						i = next_chunk++;
+					}
+					{
+						TraceSpan span(tracer, "chunk");
+						_score_lines(this->m_analyzer, data + begin, data + chunk.end, chunk.out, chunk.lines);
+					}
+					std::lock_guard<std::mutex> guard(lock);
+					done[i] = std::move(chunk);
+					changed.notify_all();
+				}
+			}));
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point last_report = start;
+		size_t start_offset = input_offset;
+		unsigned long long start_lines = lines;
+		this->m_progress.bytes_total = input_size;
+		this->m_progress.bytes_done = input_offset;
+		this->m_progress.lines_done = lines;
+		while (input_offset < input_size && !failed)
+		{
+			Chunk chunk;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				if (!changed.wait_for(guard, std::chrono::milliseconds(100), [&]() { return done.count(written_chunks) > 0; }))
+					chunk.end = 0;
+				else
+				{
+					chunk = std::move(done[written_chunks]);
+					done.erase(written_chunks);
+				}
+			}
+			if (chunk.end > 0)
+			{
+				const char *out = chunk.out.data();
+				size_t remaining = chunk.out.size();
+				while (remaining > 0 && !failed)
+				{
+					ssize_t written = write(out_fd, out, remaining);
+					if (written < 0)
+						failed = true;
+					else
+					{
+						out += written;
+						remaining -= written;
+					}
+				}
+				input_offset = chunk.end;
+				output_offset += chunk.out.size();
+				lines += chunk.lines;
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					written_chunks++;
+					if (failed)
+						this->m_error = "cannot write " + output_file;
+					changed.notify_all();
+				}
+				if (!failed && (written_chunks % this->m_checkpoint_interval == 0 || input_offset == input_size))
+					failed = fsync(out_fd) != 0 || !_write_checkpoint(checkpoint_file, input, this->m_chunk_size, input_offset, lines, output_offset);
+			}
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			this->m_progress.bytes_done = input_offset;
+			this->m_progress.lines_done = lines;
+			this->m_progress.seconds = std::chrono::duration<double>(now - start).count();
+			if (this->m_progress.seconds > 0)
+			{
+				this->m_progress.mb_per_second = (input_offset - start_offset) / 1e6 / this->m_progress.seconds;
+				this->m_progress.lines_per_second = (lines - start_lines) / this->m_progress.seconds;
+			}
+			if (this->m_progress_stream && std::chrono::duration<double>(now - last_report).count() >= this->m_progress_interval)
+			{
+				last_report = now;
+				this->_report(false);
+			}
+		}
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			failed = failed || input_offset < input_size;
+			changed.notify_all();
+		}
+		for (std::thread &worker : workers)
+			worker.join();
+		close(out_fd);
+		if (data)
+			munmap((void *)data, input_size);
+
+		if (failed && this->m_error.empty())
+			this->m_error = "cannot write " + checkpoint_file;
+		if (this->m_progress_stream)
+			this->_report(true);
+		return !failed;
+	}
+
+	void CorpusScorer::_score_lines(SentimentIntensityAnalyzer &analyzer, const char *begin, const char *end, std::string &out, unsigned long long &lines)
+	{
+		// one "compound\tneg\tneu\tpos" line per input line (a last line without a newline included)
+		char formatted[128];
+		while (begin < end)
+		{
+			const char *newline = (const char *)std::memchr(begin, '\n', end - begin);
+			const char *line_end = newline ? newline : end;
+			size_t length = line_end - begin;
+			if (length > 0 && begin[length - 1] == '\r')
+				length--;
+			Sentiment vs = analyzer.polarity_scores(String(begin, begin + length));
+			int formatted_length = std::snprintf(formatted, sizeof(formatted), "%g\t%g\t%g\t%g\n", vs.compound, vs.neg, vs.neu, vs.pos);
+			out.append(formatted, formatted_length);
+			lines++;
+			begin = newline ? newline + 1 : end;
+		}
+	}
+
+	unsigned long long CorpusScorer::_hash(const char *data, size_t length)
+	{
+		// FNV-1a
+		unsigned long long hash = 14695981039346656037ull;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool CorpusScorer::_write_checkpoint(const std::string &checkpoint_file, const CorpusInput &input, size_t chunk_size, size_t input_offset, unsigned long long lines, size_t output_offset)
+	{
+		// written to a temporary file and renamed over the old one, so a crash never leaves half a checkpoint
+		std::string temporary_file = checkpoint_file + ".tmp";
+		{
+			std::ofstream checkpoint(temporary_file, std::ios::trunc);
+			checkpoint << "vader-checkpoint 2 " << input.size << ' ' << input.modified << ' ' << input.inode << ' ' << input.head_hash << ' ' << chunk_size << ' ' << input_offset << ' ' << lines << ' ' << output_offset << '\n';
+			if (!checkpoint.flush())
+				return false;
+		}
+		return std::rename(temporary_file.c_str(), checkpoint_file.c_str()) == 0;
+	}
+
+	void CorpusScorer::_report(bool last)
+	{
+		char report[256];
+		std::snprintf(report, sizeof(report), "%s %.1f%% of %.1f MB, %llu lines, %.1f MB/s, %.0f lines/s",
+			last ? "done" : "scoring", this->m_progress.bytes_total ? 100.0 * this->m_progress.bytes_done / this->m_progress.bytes_total : 100.0,
+			this->m_progress.bytes_total / 1e6, this->m_progress.lines_done, this->m_progress.mb_per_second, this->m_progress.lines_per_second);
+		*this->m_progress_stream << report << std::endl;
+	}
+}
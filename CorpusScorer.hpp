@@ -0,0 +1,63 @@
+// vader::CorpusScorer class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <ostream>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    struct CorpusProgress
+    {
+        size_t bytes_total = 0;
+        size_t bytes_done = 0; // including the part done by earlier, interrupted runs
+        unsigned long long lines_done = 0;
+        double seconds = 0.0; // of this run
+        double mb_per_second = 0.0; // of this run, in MB of 10^6 bytes
+        double lines_per_second = 0.0;
+    };
+
+    struct CorpusInput // what a checkpoint records to tell whether the input file is still the one it was written for
+    {
+        size_t size = 0;
+        long long modified = 0; // seconds since the epoch
+        unsigned long long inode = 0;
+        unsigned long long head_hash = 0; // of the first 64 KiB
+    };
+
+    class CorpusScorer // Scores every line of (very large) text files in parallel, resuming interrupted runs from checkpoints.
+    {
+    private:
+        SentimentIntensityAnalyzer &m_analyzer;
+        int m_threads;
+        size_t m_chunk_size;
+        int m_checkpoint_interval;
+        std::ostream *m_progress_stream;
+        double m_progress_interval;
+        CorpusProgress m_progress;
+        std::string m_error;
+
+    public:
+        // chunk_size: bytes per unit of work (extended to the next newline), checkpoint_interval: chunks between checkpoints
+        CorpusScorer(SentimentIntensityAnalyzer &analyzer, int threads=0, size_t chunk_size=4 << 20, int checkpoint_interval=16);
+        ~CorpusScorer();
+
+        void set_progress_stream(std::ostream *progress_stream, double interval_seconds=5.0); // nullptr: no reports
+
+        // Writes "compound\tneg\tneu\tpos" for each input line, in input order, to output_file. Progress is checkpointed
+        // to output_file + ".checkpoint"; if that exists for the same input (same size, modification time, inode and
+        // first 64 KiB), scoring resumes after the last checkpoint.
+        bool score_file(std::string input_file, std::string output_file);
+
+        CorpusProgress get_progress();
+        std::string get_error();
+
+    private:
+        static void _score_lines(SentimentIntensityAnalyzer &analyzer, const char *begin, const char *end, std::string &out, unsigned long long &lines);
+        static unsigned long long _hash(const char *data, size_t length);
+        static bool _write_checkpoint(const std::string &checkpoint_file, const CorpusInput &input, size_t chunk_size, size_t input_offset, unsigned long long lines, size_t output_offset);
+        void _report(bool last);
+    };
+}
@@ -0,0 +1,262 @@
+// implements KeywordFilter and KeywordScorer classes
+#include "KeywordFilter.hpp"
+
+namespace vader
+{
+	static inline Char fold_case(Char c)
+	{
+		return c >= u8'A' && c <= u8'Z' ? c + (u8'a' - u8'A') : c;
+	}
+
+	static inline bool is_word_byte(Char c)
+	{
+		return c < 128 && std::isalnum(c);
+	}
+
+	KeywordFilter::KeywordFilter(bool whole_words)
+		: m_build(1), m_whole_words(whole_words), m_compiled(false), m_keyword_count(0), m_next_id(0)
+	{
+	}
+
+	KeywordFilter::~KeywordFilter()
+	{
+	}
+
+	int KeywordFilter::add_keyword(String keyword)
+	{
+		if (keyword.empty())
+			return -1;
+		int node = this->_insert(keyword);
+		if (this->m_build[node].id < 0)
+			this->_set_id(node, this->m_next_id);
+		return this->m_build[node].id;
+	}
+
+	void KeywordFilter::add_keyword(String keyword, int id)
+	{
+		if (keyword.empty())
+			return;
+		this->_set_id(this->_insert(keyword), id);
+	}
+
+	bool KeywordFilter::load_keywords(std::string keyword_file)
+	{
+		std::ifstream in(keyword_file, std::ios::binary);
+		if (!in)
+			return false;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			size_t tab = line.find('\t');
+			String keyword(line.begin(), line.begin() + std::min(tab, line.size()));
+			if (tab == std::string::npos)
+				this->add_keyword(keyword);
+			else
+				this->add_keyword(keyword, std::atoi(line.c_str() + tab + 1));
+		}
+		return true;
+	}
+
+	int KeywordFilter::keyword_count()
+	{
+		return this->m_keyword_count;
+	}
+
+	void KeywordFilter::compile()
+	{
+		// The trie's nodes are the automaton's states; fail links are filled breadth first, so each is found from the
+		// already linked, shallower states
+		size_t n = this->m_build.size();
+		this->m_first_edge.assign(n + 1, 0);
+		this->m_edge_bytes.clear();
+		this->m_edge_states.clear();
+		this->m_ids.assign(n, -1);
+		for (size_t state = 0; state < n; state++)
+		{
+			std::vector<std::pair<Char, int>> &children = this->m_build[state].children;
+			std::sort(children.begin(), children.end());
+			this->m_first_edge[state] = this->m_edge_bytes.size();
+			for (std::pair<Char, int> &edge : children)
+			{
+				this->m_edge_bytes.push_back(edge.first);
+				this->m_edge_states.push_back(edge.second);
+			}
+			this->m_ids[state] = this->m_build[state].id;
+		}
+		this->m_first_edge[n] = this->m_edge_bytes.size();
+
+		std::fill(this->m_byte_classes, this->m_byte_classes + 256, 0);
+		this->m_class_count = 1;
+		for (Char c : this->m_edge_bytes)
+			if (this->m_byte_classes[c] == 0)
+				this->m_byte_classes[c] = this->m_class_count++;
+		std::vector<Char> class_bytes(this->m_class_count, 0); // a byte of each class, class 0 never has an edge
+		for (int c = 0; c < 256; c++)
+			class_bytes[this->m_byte_classes[c]] = c;
+
+		// breadth first: a state's fail link and dense row only need the shallower states, and the dense rows go to the
+		// shallowest states until the table is full
+		const size_t max_dense = 1 << 20; // transitions, 4 MiB
+		this->m_fail.assign(n, 0);
+		this->m_output.assign(n, -1);
+		this->m_depths.assign(n, 0);
+		this->m_dense_rows.assign(n, -1);
+		this->m_dense.clear();
+		this->m_compiled = true;
+		std::vector<int> queue { 0 };
+		for (size_t k = 0; k < queue.size(); k++)
+		{
+			int state = queue[k];
+			for (std::pair<Char, int> &edge : this->m_build[state].children)
+			{
+				int child = edge.second;
+				this->m_fail[child] = state == 0 ? 0 : this->_next(this->m_fail[state], edge.first);
+				this->m_output[child] = this->m_ids[child] >= 0 ? child : this->m_output[this->m_fail[child]];
+				this->m_depths[child] = this->m_depths[state] + 1;
+				queue.push_back(child);
+			}
+			if (this->m_dense.size() + this->m_class_count <= max_dense)
+			{
+				std::vector<int> row(this->m_class_count);
+				for (int byte_class = 0; byte_class < this->m_class_count; byte_class++)
+					row[byte_class] = byte_class == 0 ? 0 : this->_next(state, class_bytes[byte_class]);
+				this->m_dense_rows[state] = this->m_dense.size() / this->m_class_count;
+				this->m_dense.insert(this->m_dense.end(), row.begin(), row.end());
+			}
+		}
+	}
+
+	bool KeywordFilter::match(const String &text, std::vector<int> &ids) const
+	{
+		ids.clear();
+		this->_scan(text, [&](int id) { ids.push_back(id); return false; });
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		return !ids.empty();
+	}
+
+	bool KeywordFilter::matches(const String &text) const
+	{
+		return this->_scan(text, [](int) { return true; });
+	}
+
+	int KeywordFilter::_insert(const String &keyword)
+	{
+		// the trie node where the keyword (ASCII case folded) ends, added if needed
+		int node = 0;
+		for (Char c : keyword)
+		{
+			c = fold_case(c);
+			int child = -1;
+			for (std::pair<Char, int> &edge : this->m_build[node].children)
+				if (edge.first == c)
+					child = edge.second;
+			if (child < 0)
+			{
+				child = this->m_build.size();
+				this->m_build[node].children.push_back(std::make_pair(c, child));
+				this->m_build.push_back(BuildNode());
+			}
+			node = child;
+		}
+		return node;
+	}
+
+	void KeywordFilter::_set_id(int node, int id)
+	{
+		if (this->m_build[node].id < 0)
+			this->m_keyword_count++;
+		this->m_build[node].id = id;
+		this->m_next_id = std::max(this->m_next_id, id + 1); // so ids given by add_keyword(keyword) never collide with it
+		this->m_compiled = false;
+	}
+
+	int KeywordFilter::_next(int state, Char c) const
+	{
+		while (true)
+		{
+			if (this->m_dense_rows[state] >= 0)
+				return this->m_dense[this->m_dense_rows[state] * this->m_class_count + this->m_byte_classes[c]];
+			const Char *begin = this->m_edge_bytes.data() + this->m_first_edge[state];
+			const Char *end = this->m_edge_bytes.data() + this->m_first_edge[state + 1];
+			const Char *edge = std::lower_bound(begin, end, c);
+			if (edge != end && *edge == c)
+				return this->m_edge_states[edge - this->m_edge_bytes.data()];
+			if (state == 0)
+				return 0; // only while compiling, before the root has its dense row
+			state = this->m_fail[state];
+		}
+	}
+
+	template <class Found>
+	bool KeywordFilter::_scan(const String &text, Found found) const
+	{
+		// Calls found(id) for every keyword occurrence, in order of where it ends, until found returns true
+		if (!this->m_compiled)
+			return false;
+		int state = 0;
+		for (size_t i = 0; i < text.length(); i++)
+		{
+			state = this->_next(state, fold_case(text[i]));
+			for (int output = this->m_output[state]; output >= 0; output = this->m_output[this->m_fail[output]])
+			{
+				size_t begin = i + 1 - this->m_depths[output];
+				if (this->m_whole_words && ((begin > 0 && is_word_byte(text[begin - 1])) || (i + 1 < text.length() && is_word_byte(text[i + 1]))))
+					continue;
+				if (found(this->m_ids[output]))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	KeywordScorer::KeywordScorer(SentimentIntensityAnalyzer &analyzer, const KeywordFilter &filter)
+		: m_analyzer(analyzer), m_filter(filter), m_texts(0), m_scored(0)
+	{
+	}
+
+	KeywordScorer::~KeywordScorer()
+	{
+	}
+
+	bool KeywordScorer::polarity_scores(String text, KeywordSentiment &res)
+	{
+		// The filter is a single pass over the bytes; a text without a keyword costs that and nothing more
+		this->m_texts.fetch_add(1, std::memory_order_relaxed);
+		std::vector<int> keywords;
+		{
+			TraceSpan span(this->m_analyzer.get_tracer(), "keyword filter");
+			if (!this->m_filter.match(text, keywords))
+				return false;
+		}
+		this->m_scored.fetch_add(1, std::memory_order_relaxed);
+		res.keywords = std::move(keywords);
+		res.sentiment = this->m_analyzer.polarity_scores(text);
+		return true;
+	}
+
+	std::vector<KeywordSentiment> KeywordScorer::polarity_scores_batch(const std::vector<String> &texts)
+	{
+		TraceSpan span(this->m_analyzer.get_tracer(), "batch");
+		std::vector<KeywordSentiment> res;
+		KeywordSentiment scored;
+		for (size_t i = 0; i < texts.size(); i++)
+		{
+			if (!this->polarity_scores(texts[i], scored))
+				continue;
+			scored.index = i;
+			res.push_back(std::move(scored));
+		}
+		return res;
+	}
+
+	KeywordStats KeywordScorer::get_stats()
+	{
+		KeywordStats stats;
+		stats.texts = this->m_texts.load(std::memory_order_relaxed);
+		stats.scored = this->m_scored.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -0,0 +1,96 @@
+// vader::KeywordFilter class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    class KeywordFilter // Finds every keyword of a (large) set in a text in one pass, with an Aho-Corasick automaton.
+    {
+    private:
+        struct BuildNode
+        {
+            std::vector<std::pair<Char, int>> children;
+            int id = -1; // of the keyword ending here
+        };
+
+        std::vector<BuildNode> m_build; // the keyword trie, until compile()
+        bool m_whole_words;
+        bool m_compiled;
+        int m_keyword_count;
+        int m_next_id; // above every id given so far
+
+        // compiled automaton: the shallowest states (where scanning spends most of its time) have dense rows of complete
+        // transitions, fail links included, over byte classes (one per byte used in a keyword, and one for all others);
+        // the other states have sorted (byte, state) edges in m_edge_bytes/m_edge_states, from m_first_edge[state] to
+        // m_first_edge[state + 1], and fall back along their fail links
+        int m_byte_classes[256];
+        int m_class_count;
+        std::vector<int> m_dense_rows; // row of each state in m_dense, -1 for none
+        std::vector<int> m_dense;
+        std::vector<int> m_first_edge;
+        std::vector<Char> m_edge_bytes;
+        std::vector<int> m_edge_states;
+        std::vector<int> m_fail; // longest proper suffix of the state's string that is also a trie state
+        std::vector<int> m_output; // nearest state on the fail chain (this one included) where a keyword ends, -1 for none
+        std::vector<int> m_ids; // keyword id ending at each state, -1 for none
+        std::vector<int> m_depths; // length of each state's string
+
+    public:
+        // whole_words: a keyword only matches where it is not preceded or followed by an ASCII letter or digit, so
+        // "apple" does not match in "pineapple". Matching ignores ASCII case.
+        KeywordFilter(bool whole_words=true);
+        ~KeywordFilter();
+
+        int add_keyword(String keyword); // returns its id: a new one, or the one it already has if added before (ignoring ASCII case)
+        void add_keyword(String keyword, int id); // several keywords may share an id, a keyword added twice keeps the later id
+        bool load_keywords(std::string keyword_file); // a keyword per line, optionally followed by a tab and its id
+        int keyword_count();
+        void compile(); // after adding keywords, before matching
+
+        // the sorted, distinct ids of the keywords found in text, false if none (or if not compiled)
+        bool match(const String &text, std::vector<int> &ids) const;
+        bool matches(const String &text) const; // stops at the first keyword found
+
+    private:
+        int _insert(const String &keyword);
+        void _set_id(int node, int id);
+        int _next(int state, Char c) const;
+        template <class Found> bool _scan(const String &text, Found found) const;
+    };
+
+    struct KeywordSentiment
+    {
+        size_t index = 0; // of the text in the batch
+        std::vector<int> keywords; // ids of the keywords found, sorted
+        Sentiment sentiment;
+    };
+
+    struct KeywordStats
+    {
+        unsigned long long texts = 0; // run through the filter
+        unsigned long long scored = 0; // had a keyword, so were scored
+    };
+
+    class KeywordScorer // Scores only the texts that mention a keyword, skipping the rest before any scoring work.
+    {
+    private:
+        SentimentIntensityAnalyzer &m_analyzer;
+        const KeywordFilter &m_filter;
+        std::atomic<unsigned long long> m_texts;
+        std::atomic<unsigned long long> m_scored;
+
+    public:
+        KeywordScorer(SentimentIntensityAnalyzer &analyzer, const KeywordFilter &filter); // filter must be compiled
+        ~KeywordScorer();
+
+        bool polarity_scores(String text, KeywordSentiment &res); // false (and res untouched) if the text has no keyword
+        std::vector<KeywordSentiment> polarity_scores_batch(const std::vector<String> &texts); // only the matching texts, in order
+
+        KeywordStats get_stats();
+    };
+}
@@ -0,0 +1,202 @@
+// implements Lexicon class
+#include "Lexicon.hpp"
+
+#include <cstring>
+
+namespace vader
+{
+	Lexicon::Lexicon()
+		: m_hot_mask(0), m_profiling(false), m_hot_hits(0), m_hot_misses(0), m_full_hits(0), m_full_misses(0)
+	{
+	}
+
+	Lexicon::~Lexicon()
+	{
+	}
+
+	double & Lexicon::operator[](const String &word)
+	{
+		double &valence = this->m_entries[word];
+		HotEntry *hot = (HotEntry *)this->_find_hot(word);
+		if (hot && !hot->in_lexicon)
+		{
+			hot->in_lexicon = true;
+			hot->valence = &valence;
+		}
+		return valence;
+	}
+
+	size_t Lexicon::count(const String &word) const
+	{
+		return this->m_entries.count(word);
+	}
+
+	size_t Lexicon::size() const
+	{
+		return this->m_entries.size();
+	}
+
+	bool Lexicon::find(const String &word, double &valence, LexiconLookups *lookups)
+	{
+		// lookups == nullptr for lookups that should not be counted (or profiled)
+		if (lookups && this->m_profiling.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> guard(this->m_profile_lock);
+			this->m_profile[word]++;
+		}
+
+		const HotEntry *hot = this->_find_hot(word);
+		if (hot)
+		{
+			if (lookups)
+				(hot->in_lexicon ? lookups->hot_hits : lookups->hot_misses)++;
+			if (hot->in_lexicon)
+				valence = *hot->valence;
+			return hot->in_lexicon;
+		}
+		std::unordered_map<String, double>::const_iterator entry = this->m_entries.find(word);
+		if (entry == this->m_entries.end())
+		{
+			if (lookups)
+				lookups->full_misses++;
+			return false;
+		}
+		if (lookups)
+			lookups->full_hits++;
+		valence = entry->second;
+		return true;
+	}
+
+	void Lexicon::record(const LexiconLookups &lookups)
+	{
+		this->m_hot_hits.fetch_add(lookups.hot_hits, std::memory_order_relaxed);
+		this->m_hot_misses.fetch_add(lookups.hot_misses, std::memory_order_relaxed);
+		this->m_full_hits.fetch_add(lookups.full_hits, std::memory_order_relaxed);
+		this->m_full_misses.fetch_add(lookups.full_misses, std::memory_order_relaxed);
+	}
+
+	void Lexicon::start_profile()
+	{
+		std::lock_guard<std::mutex> guard(this->m_profile_lock);
+		this->m_profile.clear();
+		this->m_profiling = true;
+	}
+
+	void Lexicon::stop_profile()
+	{
+		this->m_profiling = false;
+	}
+
+	bool Lexicon::write_hot_set(std::string hot_set_file, int max_words)
+	{
+		// one "word\tlookups" line per word, most looked up first
+		std::vector<std::pair<String, unsigned long long>> hits;
+		{
+			std::lock_guard<std::mutex> guard(this->m_profile_lock);
+			hits.assign(this->m_profile.begin(), this->m_profile.end());
+		}
+		std::sort(hits.begin(), hits.end(), [](const std::pair<String, unsigned long long> &a, const std::pair<String, unsigned long long> &b) {
+			return a.second > b.second || (a.second == b.second && a.first < b.first);
+		});
+		if (hits.size() > (size_t)std::max(max_words, 0))
+			hits.resize(max_words);
+
+		std::ofstream out_file(hot_set_file);
+		for (const std::pair<String, unsigned long long> &hit : hits)
+			out_file << from_u8string(hit.first) << '\t' << hit.second << '\n';
+		return out_file.good();
+	}
+
+	bool Lexicon::load_hot_set(std::string hot_set_file)
+	{
+		// Hot entries point at the full table's values, so a stale hot set can only cost speed, never change a score.
+		// Words the lexicon does not have are kept as known misses, words that are too long are skipped.
+		std::ifstream in_file(hot_set_file);
+		if (!in_file)
+			return false;
+		std::vector<String> words;
+		String line;
+		while (std::getline(in_file, line))
+		{
+			if (line == u8"")
+				continue;
+			String word = split(line, u8'\t')[0];
+			if (word.length() > 0 && word.length() < sizeof(HotEntry::word))
+				words.push_back(word);
+		}
+
+		size_t capacity = 1;
+		while (capacity < 2 * words.size())
+			capacity *= 2;
+		this->m_hot.assign(words.empty() ? 0 : capacity, HotEntry());
+		this->m_hot_mask = capacity - 1;
+		for (const String &word : words)
+		{
+			size_t i = this->_hash(word) & this->m_hot_mask;
+			while (this->m_hot[i].word[0] != 0 && std::strcmp(this->m_hot[i].word, from_u8string(word).c_str()) != 0)
+				i = (i + 1) & this->m_hot_mask;
+			HotEntry &entry = this->m_hot[i];
+			std::memset(entry.word, 0, sizeof(HotEntry::word));
+			std::memcpy(entry.word, word.data(), word.length());
+			std::unordered_map<String, double>::const_iterator full_entry = this->m_entries.find(word);
+			entry.in_lexicon = full_entry != this->m_entries.end();
+			entry.valence = entry.in_lexicon ? &full_entry->second : nullptr;
+		}
+		return true;
+	}
+
+	int Lexicon::hot_set_size() const
+	{
+		int res = 0;
+		for (const HotEntry &entry : this->m_hot)
+			if (entry.word[0] != 0)
+				res++;
+		return res;
+	}
+
+	LexiconTierStats Lexicon::tier_stats() const
+	{
+		LexiconTierStats stats;
+		stats.hot_hits = this->m_hot_hits.load(std::memory_order_relaxed);
+		stats.hot_misses = this->m_hot_misses.load(std::memory_order_relaxed);
+		stats.full_hits = this->m_full_hits.load(std::memory_order_relaxed);
+		stats.full_misses = this->m_full_misses.load(std::memory_order_relaxed);
+		unsigned long long total = stats.hot_hits + stats.hot_misses + stats.full_hits + stats.full_misses;
+		if (total > 0)
+			stats.hot_rate = (double)(stats.hot_hits + stats.hot_misses) / total;
+		return stats;
+	}
+
+	void Lexicon::reset_tier_stats()
+	{
+		this->m_hot_hits = 0;
+		this->m_hot_misses = 0;
+		this->m_full_hits = 0;
+		this->m_full_misses = 0;
+	}
+
+	unsigned long long Lexicon::_hash(const String &word)
+	{
+		// FNV-1a
+		unsigned long long hash = 14695981039346656037ull;
+		for (Char c : word)
+		{
+			hash ^= (unsigned char)c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	const Lexicon::HotEntry * Lexicon::_find_hot(const String &word) const
+	{
+		if (this->m_hot.empty() || word.length() >= sizeof(HotEntry::word))
+			return nullptr;
+		for (size_t i = this->_hash(word) & this->m_hot_mask; this->m_hot[i].word[0] != 0; i = (i + 1) & this->m_hot_mask)
+		{
+			const HotEntry &entry = this->m_hot[i];
+			if (entry.word[word.length()] == 0 && std::memcmp(entry.word, word.data(), word.length()) == 0)
+				return &entry;
+		}
+		return nullptr;
+	}
+}
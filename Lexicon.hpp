@@ -0,0 +1,78 @@
+// vader::Lexicon class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+#include <mutex>
+
+#include "vaderSentiment.hpp"
+
+namespace vader
+{
+    struct LexiconLookups // lookups done while scoring one text, added to the lexicon's totals once per text
+    {
+        unsigned long long hot_hits = 0;
+        unsigned long long hot_misses = 0;
+        unsigned long long full_hits = 0;
+        unsigned long long full_misses = 0;
+    };
+
+    struct LexiconTierStats
+    {
+        unsigned long long hot_hits = 0; // found in the hot set
+        unsigned long long hot_misses = 0; // the hot set knows the word is not in the lexicon
+        unsigned long long full_hits = 0; // found in the full table
+        unsigned long long full_misses = 0; // the full table had to be searched to find the word is not in the lexicon
+        double hot_rate = 0.0; // share of all lookups answered by the hot set
+    };
+
+    class Lexicon // Word valences, with an optional small, cache resident hot set in front of the full table.
+    {
+    private:
+        struct HotEntry // 32 bytes, so 256 hot words take 8 KiB
+        {
+            char word[23]; // NUL padded, words of 23 bytes or more are never hot
+            bool in_lexicon; // frequent words that are not in the lexicon are kept too, so their misses stay in the hot set
+            const double *valence; // the full table's value (its nodes never move), so writes through operator[] are seen
+        };
+
+        std::unordered_map<String, double> m_entries;
+        std::vector<HotEntry> m_hot; // open addressing with linear probing, power of two size, at most half full
+        size_t m_hot_mask;
+
+        std::atomic<bool> m_profiling;
+        std::mutex m_profile_lock;
+        std::unordered_map<String, unsigned long long> m_profile; // lookups per word while profiling
+
+        std::atomic<unsigned long long> m_hot_hits;
+        std::atomic<unsigned long long> m_hot_misses;
+        std::atomic<unsigned long long> m_full_hits;
+        std::atomic<unsigned long long> m_full_misses;
+
+    public:
+        Lexicon();
+        ~Lexicon();
+
+        double & operator[](const String &word); // full table, as std::unordered_map (a hot miss added this way becomes a hot hit)
+        size_t count(const String &word) const; // full table, as std::unordered_map
+        size_t size() const;
+        bool find(const String &word, double &valence, LexiconLookups *lookups=nullptr); // hot set first, then the full table
+        void record(const LexiconLookups &lookups);
+
+        // Profiling: count the lookups of every word on a sample corpus, then write the most frequent ones as a hot set file
+        void start_profile();
+        void stop_profile();
+        bool write_hot_set(std::string hot_set_file, int max_words=256);
+        // Not synchronized with find (nor is operator[]): load before scoring starts, or while no other thread scores.
+        bool load_hot_set(std::string hot_set_file);
+        int hot_set_size() const;
+
+        LexiconTierStats tier_stats() const;
+        void reset_tier_stats();
+
+    private:
+        static unsigned long long _hash(const String &word);
+        const HotEntry * _find_hot(const String &word) const;
+    };
+}
@@ -1,16 +1,81 @@
 // implements SentiText class
 #include "SentiText.hpp"
 #include <string>
+#include <iterator>
 
 namespace vader
 {
-   SentiText::SentiText(String text)
+   SentiText::SentiText(String text, bool caps)
         : m_text(text)
     {
         m_words_and_emoticons = this->_words_and_emoticons();
         // doesn't separate words from\
         // adjacent punctuation (keeps emoticons & contractions)
-        this->m_is_cap_diff = allcap_differential(this->m_words_and_emoticons);  
+        if (caps)
+            this->_token_properties<true>();
+        else
+            this->_token_properties<false>();
+        PunctuationCounts punctuation = count_punctuation(m_text);
+        m_ep_count = punctuation.exclamation_marks;
+        m_qm_count = punctuation.question_marks;
+    }
+
+    SentiText::SentiText(const std::vector<StringView> &tokens, PunctuationCounts punctuation, bool caps)
+        : SentiText(std::vector<String>(tokens.begin(), tokens.end()), punctuation, caps)
+    {
+    }
+
+    SentiText::SentiText(std::vector<String> tokens, PunctuationCounts punctuation, bool caps)
+        : m_words_and_emoticons(std::move(tokens))
+    {
+        // Tokens as split() gives them for the emoji substituted text, with or without their punctuation stripped:
+        // stripping is idempotent (a stripped word stays the same, a kept emoticon is kept again), so either way the
+        // words, emoticon flags and every property below are those of SentiText(text)
+        m_is_emoticon.assign(m_words_and_emoticons.size(), false);
+        for (size_t i = 0; i < m_words_and_emoticons.size(); i++)
+            _strip_punc_if_word(m_words_and_emoticons[i], i);
+        if (caps)
+            this->_token_properties<true>();
+        else
+            this->_token_properties<false>();
+        m_ep_count = punctuation.exclamation_marks;
+        m_qm_count = punctuation.question_marks;
+    }
+
+    SentiText::SentiText(std::vector<SentiText> &parts)
+    {
+        // Same tokens and properties as SentiText(joined text) as long as every part after the first starts right after
+        // a space, so that no token straddles two parts. The parts keep their own m_text, the joined text is never built.
+        size_t n = 0;
+        for (SentiText &part : parts)
+            n += part.m_words_and_emoticons.size();
+        m_words_and_emoticons.reserve(n);
+        m_l_words_and_emoticons.reserve(n);
+        m_booster.reserve(n);
+        m_but_index = -1;
+        m_ep_count = 0;
+        m_qm_count = 0;
+
+        size_t allcap_words = 0;
+        for (SentiText &part : parts)
+        {
+            int offset = m_words_and_emoticons.size();
+            if (m_but_index == -1 && part.m_but_index != -1)
+                m_but_index = offset + part.m_but_index;
+            m_ep_count += part.m_ep_count;
+            m_qm_count += part.m_qm_count;
+            allcap_words += std::count(part.m_is_upper.begin(), part.m_is_upper.end(), true);
+
+            std::move(part.m_words_and_emoticons.begin(), part.m_words_and_emoticons.end(), std::back_inserter(m_words_and_emoticons));
+            std::move(part.m_l_words_and_emoticons.begin(), part.m_l_words_and_emoticons.end(), std::back_inserter(m_l_words_and_emoticons));
+            m_is_emoticon.insert(m_is_emoticon.end(), part.m_is_emoticon.begin(), part.m_is_emoticon.end());
+            m_is_upper.insert(m_is_upper.end(), part.m_is_upper.begin(), part.m_is_upper.end());
+            m_booster.insert(m_booster.end(), part.m_booster.begin(), part.m_booster.end());
+            m_is_negated.insert(m_is_negated.end(), part.m_is_negated.begin(), part.m_is_negated.end());
+            part = SentiText(u8"");
+        }
+        size_t cap_differential = n - allcap_words;
+        m_is_cap_diff = 0 < cap_differential && cap_differential < n;
     }
 
     SentiText::~SentiText()
@@ -22,16 +87,51 @@ namespace vader
         return &m_words_and_emoticons;
     }
 
-	const bool * SentiText::get_is_emoticon()
+    std::vector<String> * SentiText::get_l_words_and_emoticons()
+    {
+        return &m_l_words_and_emoticons;
+    }
+
+	const std::vector<bool> & SentiText::get_is_emoticon()
 	{
 		return m_is_emoticon;
 	}
-    
+
+	const std::vector<bool> & SentiText::get_is_upper()
+	{
+		return m_is_upper;
+	}
+
+	const std::vector<double> & SentiText::get_booster()
+	{
+		return m_booster;
+	}
+
+	const std::vector<bool> & SentiText::get_is_negated()
+	{
+		return m_is_negated;
+	}
+
     bool SentiText::isCapDiff()
     {
         return m_is_cap_diff;
     }
 
+    int SentiText::get_but_index()
+    {
+        return m_but_index;
+    }
+
+    int SentiText::get_ep_count()
+    {
+        return m_ep_count;
+    }
+
+    int SentiText::get_qm_count()
+    {
+        return m_qm_count;
+    }
+
     String SentiText::_strip_punc_if_word(String &token, int i) // TODO: modify so it returns a pair<String, bool> so that this method can be static and then modify _words_and_emoticons as necessary
     {
         // Removes all trailing and leading punctuation 
@@ -58,9 +158,48 @@ namespace vader
         // Leaves contractions and most emoticons
         // Does not preserve punc-plus-letter emoticons (e.g. :D)
         std::vector<String> wes = split(m_text);
-		m_is_emoticon = new bool[wes.size()];
+        m_is_emoticon.assign(wes.size(), false);
         for (int i = 0; i < wes.size(); i++)
             _strip_punc_if_word(wes[i], i);
         return wes;
     }
+
+    template <bool Caps>
+    void SentiText::_token_properties()
+    {
+        // Everything here depends only on the text, never on the lexicon it is scored against
+        int n = m_words_and_emoticons.size();
+        m_l_words_and_emoticons.resize(n);
+        m_is_upper.assign(n, false);
+        m_booster.assign(n, 0.0);
+        m_is_negated.assign(n, false);
+        m_but_index = -1;
+
+        int allcap_words = 0;
+        for (int i = 0; i < n; i++)
+        {
+            String &lword = m_l_words_and_emoticons[i];
+            lword = m_words_and_emoticons[i];
+            std::transform(lword.begin(), lword.end(), lword.begin(), ::tolower);
+
+            if constexpr (Caps)
+            {
+                m_is_upper[i] = isupper(m_words_and_emoticons[i]);
+                if (m_is_upper[i])
+                    allcap_words++;
+            }
+
+            std::unordered_map<String, double>::const_iterator booster = BOOSTER_DICT.find(lword);
+            if (booster != BOOSTER_DICT.end())
+                m_booster[i] = booster->second;
+
+            m_is_negated[i] = NEGATE.count(lword) > 0 || lword.find(u8"n't") != String::npos;
+
+            if (m_but_index == -1 && lword == u8"but")
+                m_but_index = i;
+        }
+        // same as allcap_differential, without testing every word for ALL CAPS a second time
+        int cap_differential = n - allcap_words;
+        m_is_cap_diff = Caps && 0 < cap_differential && cap_differential < n;
+    }
 }
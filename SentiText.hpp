@@ -12,19 +12,39 @@ namespace vader
     private:
         String m_text;
         std::vector<String> m_words_and_emoticons;
-		bool * m_is_emoticon;
+        std::vector<bool> m_is_emoticon;
         bool m_is_cap_diff;
 
+        // Lexicon independent properties, computed once so that every lexicon scored against this text can share them
+        std::vector<String> m_l_words_and_emoticons; // lowercase copy of m_words_and_emoticons
+        std::vector<bool> m_is_upper;
+        std::vector<double> m_booster; // BOOSTER_DICT scalar of each token, 0 if it is not a booster/dampener
+        std::vector<bool> m_is_negated; // token is a negation word or contains "n't"
+        int m_but_index; // index of the first "but", -1 if there is none
+        int m_ep_count;
+        int m_qm_count;
+
     public:
-        SentiText(String text);
+        SentiText(String text, bool caps=true); // caps=false skips ALL CAPS detection, every word is then treated as not ALL CAPS
+        SentiText(const std::vector<StringView> &tokens, PunctuationCounts punctuation, bool caps=true); // already split text, see below
+        SentiText(std::vector<String> tokens, PunctuationCounts punctuation, bool caps=true);
+        SentiText(std::vector<SentiText> &parts); // joins texts that were split after a space and tokenized separately, emptying the parts
         ~SentiText();
 
         std::vector<String> * get_words_and_emoticons();
-		const bool * get_is_emoticon();
+        std::vector<String> * get_l_words_and_emoticons();
+        const std::vector<bool> & get_is_emoticon();
+        const std::vector<bool> & get_is_upper();
+        const std::vector<double> & get_booster();
+        const std::vector<bool> & get_is_negated();
         bool isCapDiff();
+        int get_but_index();
+        int get_ep_count();
+        int get_qm_count();
 
     private:
 		String _strip_punc_if_word(String &token, int i);
         std::vector<String> _words_and_emoticons();
+        template <bool Caps> void _token_properties();
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,180 @@
+// implements SentimentAggregator class
+#include "SentimentAggregator.hpp"
+
+namespace vader
+{
+	SentimentAggregator::SentimentAggregator(SentimentIntensityAnalyzer &analyzer, long long window_length, int buckets, int keys_per_shard, int shards)
+		: m_analyzer(analyzer), m_buckets(std::max(buckets, 1)), m_keys_per_shard(std::max(keys_per_shard, 1))
+	{
+		this->m_bucket_width = (window_length + this->m_buckets - 1) / this->m_buckets;
+		if (this->m_bucket_width < 1)
+			this->m_bucket_width = 1;
+		for (int i = 0; i < std::max(shards, 1); i++)
+			this->m_shards.push_back(std::unique_ptr<Shard>(new Shard()));
+	}
+
+	SentimentAggregator::~SentimentAggregator()
+	{
+	}
+
+	Sentiment SentimentAggregator::add(String key, long long timestamp, String text)
+	{
+		// scoring happens outside of any lock, only the window update below touches the shard
+		Sentiment sentiment = this->m_analyzer.polarity_scores(text);
+		this->add(key, timestamp, sentiment);
+		return sentiment;
+	}
+
+	void SentimentAggregator::add(const String &key, long long timestamp, const Sentiment &sentiment)
+	{
+		if (timestamp < 0) // not counted, it would land in a negative bucket
+			return;
+		long long epoch = timestamp / this->m_bucket_width;
+		Shard &shard = this->_shard(key);
+		std::lock_guard<std::mutex> guard(shard.lock);
+		Slot &slot = this->_slot(shard, key);
+
+		Bucket &bucket = slot.buckets[epoch % this->m_buckets];
+		if (bucket.epoch > epoch) // arrived after its bucket was reused by a later part of the window
+			return;
+		if (bucket.epoch < epoch)
+			bucket = Bucket();
+		bucket.epoch = epoch;
+		bucket.count++;
+		bucket.compound_sum += sentiment.compound;
+		if (sentiment.compound >= 0.05)
+			bucket.pos++;
+		else if (sentiment.compound <= -0.05)
+			bucket.neg++;
+	}
+
+	WindowStats SentimentAggregator::window(const String &key, long long now)
+	{
+		WindowStats stats;
+		if (now < 0) // no record can be older
+			return stats;
+		long long now_epoch = now / this->m_bucket_width;
+		Shard &shard = this->_shard(key);
+		std::lock_guard<std::mutex> guard(shard.lock);
+		std::unordered_map<String, int>::iterator found = shard.index.find(key);
+		if (found == shard.index.end())
+			return stats;
+
+		double compound_sum = 0.0;
+		long long pos = 0, neg = 0;
+		for (const Bucket &bucket : shard.slots[found->second].buckets)
+		{
+			if (bucket.epoch <= now_epoch - this->m_buckets || bucket.epoch > now_epoch)
+				continue;
+			stats.count += bucket.count;
+			compound_sum += bucket.compound_sum;
+			pos += bucket.pos;
+			neg += bucket.neg;
+		}
+		if (stats.count > 0)
+		{
+			stats.mean_compound = compound_sum / stats.count;
+			stats.pos_ratio = (double)pos / stats.count;
+			stats.neg_ratio = (double)neg / stats.count;
+			stats.neu_ratio = (double)(stats.count - pos - neg) / stats.count;
+		}
+		return stats;
+	}
+
+	std::vector<HeavyHitter> SentimentAggregator::heavy_hitters(int k)
+	{
+		// approximate top k keys by record count, with the Space-Saving error bound of each count
+		std::vector<HeavyHitter> res;
+		for (std::unique_ptr<Shard> &shard : this->m_shards)
+		{
+			std::lock_guard<std::mutex> guard(shard->lock);
+			for (const Slot &slot : shard->slots)
+				res.push_back(HeavyHitter { slot.key, slot.count, slot.error });
+		}
+		std::sort(res.begin(), res.end(), [](const HeavyHitter &a, const HeavyHitter &b) { return a.count > b.count; });
+		if (res.size() > (size_t)std::max(k, 0))
+			res.resize(k);
+		return res;
+	}
+
+	SentimentAggregator::Shard & SentimentAggregator::_shard(const String &key)
+	{
+		return *this->m_shards[std::hash<String>()(key) % this->m_shards.size()];
+	}
+
+	SentimentAggregator::Slot & SentimentAggregator::_slot(Shard &shard, const String &key)
+	{
+		// Space-Saving: a new key takes a free slot, or replaces the least counted key and inherits its count as error.
+		// The least counted key is the top of the shard's heap, and a count going up only moves its slot down the heap.
+		std::unordered_map<String, int>::iterator found = shard.index.find(key);
+		int i;
+		bool added = false;
+		if (found != shard.index.end())
+			i = found->second;
+		else if ((int)shard.slots.size() < this->m_keys_per_shard)
+		{
+			i = shard.slots.size();
+			shard.slots.push_back(Slot());
+			shard.slots[i].key = key;
+			shard.slots[i].buckets.resize(this->m_buckets);
+			shard.slots[i].heap_position = shard.heap.size();
+			shard.heap.push_back(i);
+			shard.index[key] = i;
+			added = true;
+		}
+		else
+		{
+			i = shard.heap[0];
+			Slot &slot = shard.slots[i];
+			shard.index.erase(slot.key);
+			slot.key = key;
+			slot.error = slot.count;
+			std::fill(slot.buckets.begin(), slot.buckets.end(), Bucket());
+			shard.index[key] = i;
+		}
+		Slot &slot = shard.slots[i];
+		slot.count++;
+		if (added)
+			_sift_up(shard, slot.heap_position);
+		else
+			_sift_down(shard, slot.heap_position);
+		return slot;
+	}
+
+	void SentimentAggregator::_sift_up(Shard &shard, int position)
+	{
+		int i = shard.heap[position];
+		while (position > 0)
+		{
+			int parent = (position - 1) / 2;
+			if (shard.slots[shard.heap[parent]].count <= shard.slots[i].count)
+				break;
+			shard.heap[position] = shard.heap[parent];
+			shard.slots[shard.heap[position]].heap_position = position;
+			position = parent;
+		}
+		shard.heap[position] = i;
+		shard.slots[i].heap_position = position;
+	}
+
+	void SentimentAggregator::_sift_down(Shard &shard, int position)
+	{
+		int i = shard.heap[position];
+		int n = shard.heap.size();
+		while (true)
+		{
+			int child = 2 * position + 1;
+			if (child >= n)
+				break;
+			if (child + 1 < n && shard.slots[shard.heap[child + 1]].count < shard.slots[shard.heap[child]].count)
+				child++;
+			if (shard.slots[i].count <= shard.slots[shard.heap[child]].count)
+				break;
+			shard.heap[position] = shard.heap[child];
+			shard.slots[shard.heap[position]].heap_position = position;
+			position = child;
+		}
+		shard.heap[position] = i;
+		shard.slots[i].heap_position = position;
+	}
+}
@@ -0,0 +1,85 @@
+// vader::SentimentAggregator class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <mutex>
+#include <memory>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    struct WindowStats // Aggregate of the records of one key inside a time window
+    {
+        long long count = 0;
+        double mean_compound = 0.0;
+        double pos_ratio = 0.0; // share of records with compound >= 0.05
+        double neg_ratio = 0.0; // share of records with compound <= -0.05
+        double neu_ratio = 0.0;
+    };
+
+    struct HeavyHitter
+    {
+        String key;
+        long long count; // records counted for the key, over-estimated by at most error
+        long long error;
+    };
+
+    class SentimentAggregator // Rolling per-key sentiment over sliding time windows, scored and aggregated in one pass.
+    {
+    private:
+        struct Bucket
+        {
+            long long epoch = -1; // timestamp / bucket width of the records held, -1 when empty
+            long long count = 0;
+            double compound_sum = 0.0;
+            long long pos = 0;
+            long long neg = 0;
+        };
+
+        struct Slot
+        {
+            String key;
+            long long count = 0;
+            long long error = 0;
+            int heap_position = 0; // in Shard::heap
+            std::vector<Bucket> buckets;
+        };
+
+        // Each shard tracks at most m_keys_per_shard keys with the Space-Saving algorithm, so memory stays bounded
+        // however many distinct keys are seen; only the most frequent keys keep their windows.
+        struct Shard
+        {
+            std::mutex lock;
+            std::vector<Slot> slots;
+            std::unordered_map<String, int> index;
+            std::vector<int> heap; // slots as a min-heap on count, so the slot to replace is always heap[0]
+        };
+
+        SentimentIntensityAnalyzer &m_analyzer;
+        long long m_bucket_width;
+        int m_buckets;
+        int m_keys_per_shard;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+
+    public:
+        // timestamps and window_length can be in any unit (seconds, milliseconds...) as long as it is the same for both;
+        // the window slides in steps of window_length / buckets, rounded up (so a window is at least window_length long).
+        // Records with a negative timestamp are not counted. buckets, keys_per_shard and shards below 1 are taken as 1.
+        SentimentAggregator(SentimentIntensityAnalyzer &analyzer, long long window_length, int buckets=12, int keys_per_shard=256, int shards=16);
+        ~SentimentAggregator();
+
+        Sentiment add(String key, long long timestamp, String text);
+        void add(const String &key, long long timestamp, const Sentiment &sentiment);
+
+        WindowStats window(const String &key, long long now);
+        std::vector<HeavyHitter> heavy_hitters(int k);
+
+    private:
+        Shard & _shard(const String &key);
+        Slot & _slot(Shard &shard, const String &key);
+        static void _sift_up(Shard &shard, int position);
+        static void _sift_down(Shard &shard, int position);
+    };
+}
@@ -2,15 +2,40 @@
 #include "SentimentIntensityAnalyzer.hpp"
 #include "cppemojihandler.hpp"
 
+#include <thread>
+
 extern std::string from_u8string(const String &s);
 
 namespace vader
 {
+	template <class Function>
+	static void parallel_for(int count, Function f)
+	{
+		// runs f(0) ... f(count - 1) on their own threads, f(0) on the calling one
+		std::vector<std::thread> threads;
+		for (int i = 1; i < count; i++)
+			threads.push_back(std::thread(f, i));
+		f(0);
+		for (std::thread &thread : threads)
+			thread.join();
+	}
+
 	SentimentIntensityAnalyzer::SentimentIntensityAnalyzer(std::string lexicon_file, std::string emoji_lexicon)
+		: m_tracer(nullptr)
+	{
+		this->m_emoji_full_filepath = emoji_lexicon;
+		this->add_lexicon(lexicon_file);
+		this->make_emoji_dict();
+
+		this->m_emoji_bank = create_emoji_bank(m_emojis);
+	}
+
+	SentimentIntensityAnalyzer::SentimentIntensityAnalyzer(std::vector<std::string> lexicon_files, std::string emoji_lexicon)
+		: m_tracer(nullptr)
 	{
-		this->m_lexicon_full_filepath = lexicon_file; // possibly don't need the full filepath?
 		this->m_emoji_full_filepath = emoji_lexicon;
-		this->make_lex_dict();
+		for (std::string lexicon_file : lexicon_files)
+			this->add_lexicon(lexicon_file);
 		this->make_emoji_dict();
 
 		this->m_emoji_bank = create_emoji_bank(m_emojis);
@@ -20,24 +45,375 @@ namespace vader
 	{
 	}
 
+	int SentimentIntensityAnalyzer::add_lexicon(std::string lexicon_file)
+	{
+		// returns the index of the lexicon's Sentiment in the results of polarity_scores_all
+		this->m_lexicon_full_filepaths.push_back(lexicon_file); // possibly don't need the full filepath?
+		this->m_lexicons.push_back(std::unique_ptr<Lexicon>(new Lexicon()));
+		this->make_lex_dict(lexicon_file, *this->m_lexicons.back());
+		return this->m_lexicons.size() - 1;
+	}
+
+	int SentimentIntensityAnalyzer::lexicon_count()
+	{
+		return this->m_lexicons.size();
+	}
+
+	Lexicon & SentimentIntensityAnalyzer::get_lexicon(int i)
+	{
+		return *this->m_lexicons[i];
+	}
+
+	void SentimentIntensityAnalyzer::set_tracer(Tracer *tracer)
+	{
+		this->m_tracer = tracer;
+	}
+
+	Tracer * SentimentIntensityAnalyzer::get_tracer()
+	{
+		return this->m_tracer;
+	}
+
 	Sentiment SentimentIntensityAnalyzer::polarity_scores(String text)
+	{
+		return this->polarity_scores<DefaultRules>(text);
+	}
+
+	template <class Rules>
+	Sentiment SentimentIntensityAnalyzer::polarity_scores(String text)
+	{
+		return this->_polarity_scores<Rules>(text, nullptr);
+	}
+
+	template <class Rules>
+	Sentiment SentimentIntensityAnalyzer::_polarity_scores(String text, ScoreExplanation *explanation)
+	{
+		TraceSpan span(this->m_tracer, "polarity_scores");
+		TraceSpan stage(this->m_tracer, "emoji substitution");
+		String text_no_emoji = this->_replace_emojis<Rules>(text);
+		stage.next(this->m_tracer, "SentiText tokenization");
+		SentiText sentitext(std::move(text_no_emoji), Rules::caps);
+		stage.end();
+		return this->_score_lexicon<Rules>(sentitext, *this->m_lexicons[0], nullptr, explanation);
+	}
+
+	std::vector<Sentiment> SentimentIntensityAnalyzer::polarity_scores_all(String text)
+	{
+		return this->polarity_scores_all<DefaultRules>(text);
+	}
+
+	template <class Rules>
+	std::vector<Sentiment> SentimentIntensityAnalyzer::polarity_scores_all(String text)
+	{
+		// emoji substitution, tokenization and every lexicon independent rule input is computed once in SentiText,
+		// only the lexicon lookups and the rules that depend on them are repeated for each lexicon
+		SentiText sentitext(this->_replace_emojis<Rules>(text), Rules::caps);
+		std::vector<Sentiment> res;
+		res.reserve(this->m_lexicons.size());
+		for (std::unique_ptr<Lexicon> &lexicon : this->m_lexicons)
+			res.push_back(this->_score_lexicon<Rules>(sentitext, *lexicon));
+		return res;
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores_parallel(String text, int threads)
+	{
+		// Splits the text after spaces that follow an ASCII letter: no emoji or token can straddle such a split, and
+		// the emoji substitution is in the same state (just wrote a space) at the start of every part as it would be
+		// sequentially. Each part is substituted and tokenized on its own thread, then the valence rules run over
+		// ranges of the joined tokens, since they only read (never write) the 3 words before and 1 word after each
+		// word. The first "but" and the !/? counts are combined across parts, and the final sums are done in order,
+		// so the result is exactly that of polarity_scores.
+		const size_t min_part_length = 1 << 16;
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = std::min<size_t>(threads, std::max<size_t>(text.length() / min_part_length, 1));
+		if (threads == 1)
+			return this->polarity_scores(text);
+
+		TraceSpan span(this->m_tracer, "polarity_scores_parallel");
+		std::vector<size_t> split_points = this->_parallel_split_points(text, threads);
+		std::vector<SentiText> parts(split_points.size() - 1, SentiText(u8""));
+		parallel_for(parts.size(), [&](int i) {
+			TraceSpan stage(this->m_tracer, "emoji substitution and SentiText tokenization");
+			parts[i] = SentiText(this->_replace_emojis<DefaultRules>(text.substr(split_points[i], split_points[i + 1] - split_points[i])));
+		});
+		SentiText sentitext(parts);
+
+		int n = sentitext.get_l_words_and_emoticons()->size();
+		std::vector<double> sentiments(n);
+		parallel_for(threads, [&](int i) {
+			TraceSpan stage(this->m_tracer, "valence rules");
+			int begin = (long long)n * i / threads;
+			int end = (long long)n * (i + 1) / threads;
+			this->_lexicon_valences<DefaultRules>(sentitext, *this->m_lexicons[0], sentiments, begin, end);
+		});
+		this->_but_check(sentitext.get_but_index(), sentiments);
+		TraceSpan stage(this->m_tracer, "score_valence");
+		double punct_emph_amplifier = this->_amplify_ep(sentitext.get_ep_count()) + this->_amplify_qm(sentitext.get_qm_count());
+		return this->_score_sentiments<DefaultRules>(sentiments, punct_emph_amplifier);
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores(const std::vector<StringView> &tokens, PunctuationCounts punctuation)
+	{
+		SentiText sentitext(tokens, punctuation);
+		return this->_score_lexicon<DefaultRules>(sentitext, *this->m_lexicons[0]);
+	}
+
+	String SentimentIntensityAnalyzer::replace_emojis(String text)
+	{
+		return this->_replace_emojis<DefaultRules>(text);
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores(const StringView *segments, size_t count)
+	{
+		std::vector<String> tokens;
+		PunctuationCounts punctuation;
+		this->_segment_tokens(segments, count, tokens, punctuation);
+		SentiText sentitext(std::move(tokens), punctuation);
+		return this->_score_lexicon<DefaultRules>(sentitext, *this->m_lexicons[0]);
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores(String text, std::vector<String> *tokens, std::vector<double> *sentiments)
+	{
+		SentiText sentitext(this->_replace_emojis<DefaultRules>(text));
+		if (tokens)
+			*tokens = *sentitext.get_words_and_emoticons();
+		return this->_score_lexicon<DefaultRules>(sentitext, *this->m_lexicons[0], sentiments);
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores(String text, ScoreExplanation &explanation)
+	{
+		return this->_polarity_scores<ExplainRules>(text, &explanation);
+	}
+
+	Sentiment SentimentIntensityAnalyzer::polarity_scores_reference(String text, std::vector<String> *tokens, std::vector<double> *sentiments)
+	{
+		text = this->_replace_emojis<DefaultRules>(text);
+		SentiText sentitext(text);
+		std::vector<double> token_sentiments;
+		std::vector<String> words_and_emoticons = *sentitext.get_words_and_emoticons();
+		// word by word, as the original rules did, not SentiText's precomputed isCapDiff()
+		bool is_cap_diff = allcap_differential(words_and_emoticons);
+		for (int i = 0; i < (int)words_and_emoticons.size(); i++)
+		{
+			double valence = 0;
+			String lword = words_and_emoticons[i];
+			std::transform(lword.begin(), lword.end(), lword.begin(), ::tolower);
+			String lnword;
+			if (i < (int)words_and_emoticons.size() - 1)
+			{
+				lnword = words_and_emoticons[i + 1];
+				std::transform(lnword.begin(), lnword.end(), lnword.begin(), ::tolower);
+			}
+			if (BOOSTER_DICT.count(lword) > 0)
+				token_sentiments.push_back(valence);
+			else if (i < (int)words_and_emoticons.size() - 1 && lword == u8"kind" && lnword == u8"of")
+				token_sentiments.push_back(valence);
+			else
+				this->sentiment_valence(valence, sentitext, words_and_emoticons[i], i, token_sentiments, is_cap_diff);
+		}
+		this->_but_check(words_and_emoticons, token_sentiments);
+		if (tokens)
+			*tokens = words_and_emoticons;
+		if (sentiments)
+			*sentiments = token_sentiments;
+		return this->score_valence(token_sentiments, text);
+	}
+
+	std::vector<size_t> SentimentIntensityAnalyzer::_parallel_split_points(const String &text, int parts)
+	{
+		// Start of each part (and the end of the text), each part after the first starting right after a space
+		// that follows an ASCII letter
+		std::vector<size_t> split_points { 0 };
+		for (int k = 1; k < parts; k++)
+		{
+			size_t p = std::max(split_points.back(), text.length() * k / parts);
+			while (p < text.length() && !(p > 0 && text[p] == u8' ' && (unsigned char)text[p - 1] < 128 && std::isalpha((unsigned char)text[p - 1])))
+				p++;
+			if (p >= text.length() - 1)
+				break;
+			split_points.push_back(p + 1);
+		}
+		split_points.push_back(text.length());
+		return split_points;
+	}
+
+	BudgetedSentiment SentimentIntensityAnalyzer::polarity_scores(String text, const ScoreBudget &budget)
+	{
+		// Cuts are made at fixed positions (never depending on the time), so a truncated result is the same on every run
+		const int block_tokens = 4096; // tokens scored between deadline checks
+		BudgetedSentiment res;
+		res.bytes_total = text.length();
+		if (budget.max_bytes > 0 && text.length() > budget.max_bytes)
+		{
+			res.status = budget.truncate ? ScoreStatus::TRUNCATED : ScoreStatus::OVER_BUDGET;
+			if (!budget.truncate)
+				return res;
+			text.erase(this->_byte_cut(text, budget.max_bytes));
+		}
+		size_t bytes = text.length();
+
+		if (this->_past_deadline(budget))
+		{
+			res.status = ScoreStatus::DEADLINE_EXCEEDED;
+			return res;
+		}
+		std::vector<Substitution> substitutions;
+		text = this->_replace_emojis<DefaultRules>(text, budget.max_tokens > 0 ? &substitutions : nullptr);
+		if (budget.max_tokens > 0)
+		{
+			size_t cut = this->_token_cut(text, budget.max_tokens);
+			if (cut != String::npos)
+			{
+				res.status = budget.truncate ? ScoreStatus::TRUNCATED : ScoreStatus::OVER_BUDGET;
+				if (!budget.truncate)
+					return res;
+				text.erase(cut);
+				bytes = this->_source_offset(substitutions, cut);
+			}
+		}
+
+		if (this->_past_deadline(budget))
+		{
+			res.status = ScoreStatus::DEADLINE_EXCEEDED;
+			return res;
+		}
+		SentiText sentitext(text);
+		int n = sentitext.get_l_words_and_emoticons()->size();
+		std::vector<double> sentiments(n);
+		for (int begin = 0; begin < n; begin += block_tokens)
+		{
+			if (this->_past_deadline(budget))
+			{
+				res.status = ScoreStatus::DEADLINE_EXCEEDED;
+				return res;
+			}
+			this->_lexicon_valences<DefaultRules>(sentitext, *this->m_lexicons[0], sentiments, begin, std::min(begin + block_tokens, n));
+		}
+		this->_but_check(sentitext.get_but_index(), sentiments);
+		double punct_emph_amplifier = this->_amplify_ep(sentitext.get_ep_count()) + this->_amplify_qm(sentitext.get_qm_count());
+		res.sentiment = this->_score_sentiments<DefaultRules>(sentiments, punct_emph_amplifier);
+		res.bytes = bytes;
+		res.tokens = n;
+		return res;
+	}
+
+	std::vector<Sentiment> SentimentIntensityAnalyzer::polarity_scores_batch(const std::vector<String> &texts)
+	{
+		TraceSpan span(this->m_tracer, "batch");
+		std::vector<Sentiment> res;
+		res.reserve(texts.size());
+		for (const String &text : texts)
+			res.push_back(this->polarity_scores(text));
+		return res;
+	}
+
+	std::vector<BudgetedSentiment> SentimentIntensityAnalyzer::polarity_scores_batch(const std::vector<String> &texts, const ScoreBudget &budget)
+	{
+		// once the deadline has passed the remaining texts are marked DEADLINE_EXCEEDED without being looked at
+		TraceSpan span(this->m_tracer, "batch");
+		std::vector<BudgetedSentiment> res;
+		res.reserve(texts.size());
+		for (const String &text : texts)
+		{
+			if (!res.empty() && res.back().status == ScoreStatus::DEADLINE_EXCEEDED)
+			{
+				BudgetedSentiment skipped;
+				skipped.status = ScoreStatus::DEADLINE_EXCEEDED;
+				skipped.bytes_total = text.length();
+				res.push_back(skipped);
+			}
+			else
+				res.push_back(this->polarity_scores(text, budget));
+		}
+		return res;
+	}
+
+	size_t SentimentIntensityAnalyzer::_byte_cut(const String &text, size_t max_bytes)
+	{
+		// length of the longest prefix of at most max_bytes that ends before a whitespace character, or failing
+		// that (one long word) at a UTF-8 character boundary
+		for (size_t cut = max_bytes; cut > 0; cut--)
+			if (std::isspace((unsigned char)text[cut]))
+				return cut;
+		size_t cut = max_bytes;
+		while (cut > 0 && ((unsigned char)text[cut] & 0xC0) == 0x80)
+			cut--;
+		return cut;
+	}
+
+	size_t SentimentIntensityAnalyzer::_token_cut(const String &text, size_t max_tokens)
+	{
+		// position where split() would start token max_tokens + 1, String::npos if the text has no more than max_tokens
+		size_t tokens = 0;
+		bool n = true;
+		for (size_t i = 0; i < text.length(); i++)
+		{
+			Char c = text[i];
+			if (n)
+			{
+				if (tokens == max_tokens)
+					return i;
+				tokens++;
+				n = false;
+			}
+			else if (c == u8' ' || c == u8'\t' || c == u8'\n' || c == u8'\r' || c == u8'\f' || c == u8'\v')
+				n = true;
+		}
+		return String::npos;
+	}
+
+	size_t SentimentIntensityAnalyzer::_source_offset(const std::vector<Substitution> &substitutions, size_t result_offset)
+	{
+		// offset in the text given to _replace_emojis of an offset in its result, which advance together outside the
+		// substitutions; an offset inside an emoji's description (so part of it comes before) counts the whole emoji
+		std::vector<Substitution>::const_iterator next = std::upper_bound(substitutions.begin(), substitutions.end(), result_offset,
+			[](size_t offset, const Substitution &substitution) { return offset < substitution.result_begin; });
+		if (next == substitutions.begin())
+			return result_offset;
+		const Substitution &substitution = *(next - 1);
+		if (result_offset == substitution.result_begin)
+			return substitution.begin;
+		if (result_offset < substitution.result_end)
+			return substitution.end;
+		return substitution.end + (result_offset - substitution.result_end);
+	}
+
+	bool SentimentIntensityAnalyzer::_past_deadline(const ScoreBudget &budget)
+	{
+		return budget.deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= budget.deadline;
+	}
+
+	template <class Rules>
+	String SentimentIntensityAnalyzer::_replace_emojis(const String &text, std::vector<Substitution> *substitutions)
 	{
 		// convert emojis to their textual descriptions
+		// (without Rules::emoji only the collapsing of spaces is left, so emoji free text is tokenized the same way)
 		String text_no_emoji = u8"";
+		if (substitutions)
+			substitutions->clear();
 		bool prev_space = true;
-		for (int i = 0; i < text.length(); i++) // Char c : text
+		for (size_t i = 0; i < text.length(); i++) // Char c : text
 		{
 			Char c = text[i];
 			String temp = u8""; temp.push_back(c);
-			if (this->m_emoji_bank[0].count(c))
-				temp = emoji_chars_from_start(text.substr(i), this->m_emoji_bank);
-			if (temp.length() > 0 && this->m_emojis.count(temp))
+			std::unordered_map<String, String>::const_iterator emoji = this->m_emojis.end();
+			if constexpr (Rules::emoji)
+			{
+				if (this->m_emoji_bank[0].count(c))
+					temp = emoji_chars_from_start(text, i, this->m_emoji_bank);
+				if (temp.length() > 0)
+					emoji = this->m_emojis.find(temp);
+			}
+			if (emoji != this->m_emojis.end())
 			{
-				String description = this->m_emojis[temp];
 				if (!prev_space)
 					text_no_emoji += u8" ";
-				text_no_emoji += description + u8" "; // so that emoji sentiments can be parsed separately
+				size_t result_begin = text_no_emoji.length();
+				text_no_emoji += emoji->second + u8" "; // so that emoji sentiments can be parsed separately
 				prev_space = true;
+				if (substitutions)
+					substitutions->push_back({ i, i + temp.length(), result_begin, text_no_emoji.length() });
 			}
 			/*
 			if (this->m_emojis.count(temp) > 0)
@@ -54,39 +430,287 @@ namespace vader
 				text_no_emoji += temp;
 				prev_space = c == u8' ';
 			}
+			else if (substitutions) // a dropped space
+			{
+				if (!substitutions->empty() && substitutions->back().end == i && substitutions->back().result_end == text_no_emoji.length())
+					substitutions->back().end++;
+				else
+					substitutions->push_back({ i, i + 1, text_no_emoji.length(), text_no_emoji.length() });
+			}
 			i += temp.length() - 1;
 		}
-		if (text_no_emoji[text_no_emoji.length() - 1] == u8' ')
+		if (text_no_emoji.length() > 0 && text_no_emoji[text_no_emoji.length() - 1] == u8' ')
 			text_no_emoji.erase(text_no_emoji.length() - 1);
-		text = text_no_emoji;
+		return text_no_emoji;
+	}
 
-		SentiText sentitext(text);
-		std::vector<double> sentiments;
+	void SentimentIntensityAnalyzer::_segment_tokens(const StringView *segments, size_t count, std::vector<String> &tokens, PunctuationCounts &punctuation)
+	{
+		// _replace_emojis<DefaultRules> followed by split() and the !/? counts, in one pass over the segments as if they
+		// were one text: emoji and tokens may straddle segment boundaries, but only the tokens are ever copied
+		bool new_token = true;
+		auto split_char = [&](Char c) {
+			if (new_token)
+			{
+				tokens.push_back(String(1, c));
+				new_token = false;
+			}
+			else if (c == u8' ' || c == u8'\t' || c == u8'\n' || c == u8'\r' || c == u8'\f' || c == u8'\v')
+				new_token = true;
+			else
+				tokens.back().push_back(c);
+			if (c == u8'!')
+				punctuation.exclamation_marks++;
+			else if (c == u8'?')
+				punctuation.question_marks++;
+		};
+		bool held_space = false; // a space is only passed on once something follows it, as _replace_emojis drops a final space
+		auto put = [&](const String &s) {
+			for (Char c : s)
+			{
+				if (held_space)
+					split_char(u8' ');
+				held_space = c == u8' ';
+				if (!held_space)
+					split_char(c);
+			}
+		};
 
-		std::vector<String> words_and_emoticons = *sentitext.get_words_and_emoticons();
+		bool prev_space = true;
+		size_t s = 0, offset = 0; // position in segments[s]
+		while (true)
+		{
+			while (s < count && offset >= segments[s].size())
+			{
+				s++;
+				offset = 0;
+			}
+			if (s == count)
+				break;
+			Char c = segments[s][offset];
+			String temp(1, c);
+			if (this->m_emoji_bank[0].count(c))
+			{
+				// emoji_chars_from_start across segments
+				temp.clear();
+				size_t t = s, t_offset = offset;
+				for (size_t k = 0; k < this->m_emoji_bank.size(); k++)
+				{
+					while (t < count && t_offset >= segments[t].size())
+					{
+						t++;
+						t_offset = 0;
+					}
+					if (t == count || !this->m_emoji_bank[k].count(segments[t][t_offset]))
+						break;
+					temp.push_back(segments[t][t_offset++]);
+				}
+			}
+			std::unordered_map<String, String>::const_iterator emoji = this->m_emojis.find(temp);
+			if (emoji != this->m_emojis.end())
+			{
+				if (!prev_space)
+					put(u8" ");
+				put(emoji->second + u8" ");
+				prev_space = true;
+			}
+			else if (!(prev_space && temp == u8" "))
+			{
+				put(temp);
+				prev_space = c == u8' ';
+			}
 
-		for (int i = 0; i < words_and_emoticons.size(); i++)
+			for (size_t skip = temp.length(); skip > 0; )
+			{
+				size_t step = std::min(skip, segments[s].size() - offset);
+				offset += step;
+				skip -= step;
+				if (skip > 0)
+				{
+					s++;
+					offset = 0;
+				}
+			}
+		}
+	}
+
+	template <class Rules>
+	Sentiment SentimentIntensityAnalyzer::_score_lexicon(SentiText &sentitext, Lexicon &lexicon, std::vector<double> *token_sentiments, ScoreExplanation *explanation)
+	{
+		TraceSpan stage(this->m_tracer, "valence rules");
+		std::vector<double> sentiments(sentitext.get_l_words_and_emoticons()->size());
+		TokenContribution *contributions = nullptr;
+		if constexpr (Rules::explain)
 		{
-			double valence = 0;
-			// check for vader_lexicon words that may be used as modifiers or negations
-			String lword = words_and_emoticons[i];
-			std::transform(lword.begin(), lword.end(), lword.begin(), ::tolower);
-			String lnword;
-			if (i < words_and_emoticons.size() - 1)
+			// assigned in place, so a reused explanation keeps its token strings' buffers
+			const std::vector<String> &words_and_emoticons = *sentitext.get_words_and_emoticons();
+			explanation->tokens.resize(sentiments.size());
+			for (size_t i = 0; i < sentiments.size(); i++)
 			{
-				lnword = words_and_emoticons[i + 1];
-				std::transform(lnword.begin(), lnword.end(), lnword.begin(), ::tolower);
+				explanation->tokens[i].token = words_and_emoticons[i];
+				explanation->tokens[i].lexicon_valence = 0.0;
+				explanation->tokens[i].rules = 0;
+			}
+			contributions = explanation->tokens.data();
+		}
+		this->_lexicon_valences<Rules>(sentitext, lexicon, sentiments, 0, sentiments.size(), contributions);
+		this->_but_check(sentitext.get_but_index(), sentiments);
+		if (token_sentiments)
+			*token_sentiments = sentiments;
+		stage.next(this->m_tracer, "score_valence");
+		double punct_emph_amplifier = this->_amplify_ep(sentitext.get_ep_count()) + this->_amplify_qm(sentitext.get_qm_count());
+		if constexpr (Rules::explain)
+		{
+			// contributions hold the valences from before the "but" rule
+			for (size_t i = 0; i < sentiments.size(); i++)
+			{
+				if (sentiments[i] != contributions[i].valence)
+					contributions[i].rules |= RULE_BUT;
+				contributions[i].valence = sentiments[i];
+			}
+			explanation->punctuation_emphasis = punct_emph_amplifier;
+		}
+		return this->_score_sentiments<Rules>(sentiments, punct_emph_amplifier);
+	}
+
+	template <class Rules>
+	void SentimentIntensityAnalyzer::_lexicon_valences(SentiText &sentitext, Lexicon &lexicon, std::vector<double> &sentiments, int begin, int end,
+		TokenContribution *contributions)
+	{
+		// Same rules as sentiment_valence, reading the lexicon independent properties precomputed by SentiText
+		// Fills sentiments[begin, end), sentiments must already have one element per word. With Rules::explain,
+		// contributions[i] gets the lexicon valence, the valence and the rules that changed it as they are applied.
+		const std::vector<String> &words_and_emoticons = *sentitext.get_l_words_and_emoticons();
+		const std::vector<bool> &is_upper = sentitext.get_is_upper();
+		const std::vector<bool> &is_emoticon = sentitext.get_is_emoticon();
+		const std::vector<double> &booster = sentitext.get_booster();
+		bool is_cap_diff = sentitext.isCapDiff();
+		int n = words_and_emoticons.size();
+
+		// look every word the rules can reach up once (the 3 words before the range and the one after it as well),
+		// the rules below only ever ask about these. Only the range's own lookups count towards the tier stats.
+		int lo = std::max(begin - 3, 0);
+		int hi = std::min(end + 1, n);
+		std::vector<double> lexicon_valence(hi - lo, 0.0);
+		std::vector<bool> in_lexicon_range(hi - lo, false);
+		LexiconLookups lookups;
+		for (int i = lo; i < hi; i++)
+		{
+			double valence;
+			if (lexicon.find(words_and_emoticons[i], valence, begin <= i && i < end ? &lookups : nullptr))
+			{
+				lexicon_valence[i - lo] = valence;
+				in_lexicon_range[i - lo] = true;
 			}
-			if (BOOSTER_DICT.count(lword) > 0)
-				sentiments.push_back(valence);
-			else if (i < words_and_emoticons.size() - 1 && lword == u8"kind" && lnword == u8"of")
-				sentiments.push_back(valence);
-			else
-				this->sentiment_valence(valence, sentitext, words_and_emoticons[i], i, sentiments);
 		}
+		lexicon.record(lookups);
+		auto in_lexicon = [&](int i) { return in_lexicon_range[i - lo]; };
 
-		this->_but_check(words_and_emoticons, sentiments);
-		return this->score_valence(sentiments, text);
+		for (int i = begin; i < end; i++)
+		{
+			double valence = 0;
+			// vader_lexicon words that are used as modifiers ("kind of" or boosters) carry no valence themselves
+			bool modifier = booster[i] != 0 || (i < n - 1 && words_and_emoticons[i] == u8"kind" && words_and_emoticons[i + 1] == u8"of");
+			if (modifier || !in_lexicon(i))
+			{
+				sentiments[i] = valence;
+				if constexpr (Rules::explain)
+				{
+					contributions[i].lexicon_valence = in_lexicon(i) ? lexicon_valence[i - lo] : 0.0;
+					contributions[i].valence = valence;
+					contributions[i].rules = 0;
+					if (in_lexicon(i))
+						contributions[i].rules = RULE_MODIFIER;
+				}
+				continue;
+			}
+			valence = lexicon_valence[i - lo];
+			unsigned int rules = 0;
+
+			// check for "no" as negation for an adjacent lexicon item vs "no" as its own stand-alone lexicon item
+			if (words_and_emoticons[i] == u8"no" && i != n - 1 && in_lexicon(i + 1))
+			{
+				valence = 0.0;
+				if constexpr (Rules::explain)
+					rules |= RULE_NEGATION;
+			}
+			// check if sentiment laden word is in ALL CAPS (while others aren't)
+			if constexpr (Rules::caps)
+			{
+				if (is_upper[i] && is_cap_diff && !is_emoticon[i])
+				{
+					if (valence > 0)
+						valence += C_INCR;
+					else
+						valence -= C_INCR;
+					if constexpr (Rules::explain)
+						rules |= RULE_CAPS;
+				}
+			}
+
+			for (int start_i = 0; start_i < 3 && start_i < i; start_i++)
+			{
+				int j = i - (start_i + 1);
+				if (in_lexicon(j))
+					continue;
+				// scalar_inc_dec with the booster lookup already done
+				double s = booster[j];
+				if (s != 0)
+				{
+					if (valence < 0)
+						s *= -1;
+					if constexpr (Rules::caps)
+					{
+						if (is_cap_diff && is_upper[j])
+						{
+							if (valence > 0)
+								s += C_INCR;
+							else
+								s -= C_INCR;
+						}
+					}
+					if (start_i == 1)
+						s *= 0.95;
+					else if (start_i == 2)
+						s *= 0.9;
+					if constexpr (Rules::explain)
+						rules |= RULE_BOOSTER;
+				}
+				valence = valence + s;
+				double before = valence;
+				valence = this->_negation_check(valence, sentitext, start_i, i);
+				if constexpr (Rules::explain)
+				{
+					// a negation (N_SCALAR) flips the sign, "never so/this" amplifies like a booster
+					if (valence != before)
+						rules |= (valence < 0) != (before < 0) ? RULE_NEGATION : RULE_BOOSTER;
+				}
+				if constexpr (Rules::idioms)
+				{
+					if (start_i == 2)
+					{
+						before = valence;
+						valence = this->_special_idioms_check(valence, sentitext, i);
+						if constexpr (Rules::explain)
+						{
+							if (valence != before)
+								rules |= RULE_IDIOM;
+						}
+					}
+				}
+			}
+			double before = valence;
+			valence = this->_least_check(valence, sentitext, i);
+			sentiments[i] = valence;
+			if constexpr (Rules::explain)
+			{
+				contributions[i].lexicon_valence = lexicon_valence[i - lo];
+				contributions[i].valence = valence;
+				if (valence != before)
+					rules |= RULE_LEAST;
+				contributions[i].rules = rules;
+			}
+		}
 	}
 
 	int SentimentIntensityAnalyzer::char_byte_count(Char val)
@@ -105,9 +729,9 @@ namespace vader
 		}
 	}
 
-	void SentimentIntensityAnalyzer::make_lex_dict() // TODO: in the future maybe switch to a C-style file reading implementation if possible
+	void SentimentIntensityAnalyzer::make_lex_dict(std::string lexicon_file, Lexicon &lexicon) // TODO: in the future maybe switch to a C-style file reading implementation if possible
 	{
-		std::ifstream in_file(m_lexicon_full_filepath);
+		std::ifstream in_file(lexicon_file);
 		String line;
 		while (std::getline(in_file, line))
 		{
@@ -117,7 +741,7 @@ namespace vader
 			String word = tokens[0];
 			String measure = tokens[1];
 
-			m_lexicon[word] = std::stod(from_u8string(measure));
+			lexicon[word] = std::stod(from_u8string(measure));
 		}
 	}
 
@@ -137,26 +761,26 @@ namespace vader
 		}
 	}
 
-	void SentimentIntensityAnalyzer::sentiment_valence(double valence, SentiText sentitext, String item, int i, std::vector<double> &sentiments)
+	void SentimentIntensityAnalyzer::sentiment_valence(double valence, SentiText &sentitext, String item, int i, std::vector<double> &sentiments, bool is_cap_diff)
 	{
-		bool is_cap_diff = sentitext.isCapDiff();
-		std::vector<String> words_and_emoticons = *sentitext.get_words_and_emoticons();
+		Lexicon &lexicon = *this->m_lexicons[0];
+		const std::vector<String> &words_and_emoticons = *sentitext.get_words_and_emoticons();
 		String item_lowercase = item;
 		std::transform(item_lowercase.begin(), item_lowercase.end(), item_lowercase.begin(), ::tolower);
-		if (this->m_lexicon.count(item_lowercase) > 0)
+		if (lexicon.count(item_lowercase) > 0)
 		{
 			// get the sentiment valence
-			valence = this->m_lexicon[item_lowercase];
+			valence = lexicon[item_lowercase];
 
 			String next_word;
-			if (i != words_and_emoticons.size() - 1)
+			if (i != (int)words_and_emoticons.size() - 1)
 			{
 				next_word = words_and_emoticons[i + 1];
 				std::transform(next_word.begin(), next_word.end(), next_word.begin(), ::tolower);
 			}
 
 			// check for "no" as negation for an adjacent lexicon item vs "no" as its own stand-alone lexicon item
-			if (item_lowercase == u8"no" && i != words_and_emoticons.size() - 1 && this->m_lexicon.count(next_word) > 0)
+			if (item_lowercase == u8"no" && i != (int)words_and_emoticons.size() - 1 && lexicon.count(next_word) > 0)
 				// don't use valence of "no" as a lexicon item. Instead set it's valence to 0.0 and negate the next item
 				valence = 0.0;
 			// check if sentiment laden word is in ALL CAPS (while others aren't)
@@ -179,7 +803,7 @@ namespace vader
 				{
 					String temp = words_and_emoticons[i - (start_i + 1)];
 					std::transform(temp.begin(), temp.end(), temp.begin(), ::tolower);
-					if (m_lexicon.count(temp) == 0)
+					if (lexicon.count(temp) == 0)
 					{
 						double s = scalar_inc_dec(words_and_emoticons[i - (start_i + 1)], valence, is_cap_diff);
 						if (s != 0)
@@ -228,11 +852,28 @@ namespace vader
 		return valence;
 	}
 
+	double SentimentIntensityAnalyzer::_least_check(double valence, SentiText &sentitext, int i)
+	{
+		// check for negation case using "least", on the already lowercased words
+		const std::vector<String> &words_and_emoticons_lower = *sentitext.get_l_words_and_emoticons();
+		if (i > 0 && words_and_emoticons_lower[i - 1] == u8"least")
+		{
+			if (i > 1)
+			{
+				if (words_and_emoticons_lower[i - 2] != u8"at" && words_and_emoticons_lower[i - 2] != u8"very")
+					valence *= N_SCALAR;
+			}
+			else
+				valence *= N_SCALAR;
+		}
+		return valence;
+	}
+
 	void SentimentIntensityAnalyzer::_but_check(const std::vector<String> &words_and_emoticons, std::vector<double> &sentiments)
 	{
 		// check for modification in sentiment due to contrastive conjunction 'but'
 		std::vector<int> bi;
-		for (int i = 0; i < words_and_emoticons.size(); i++)
+		for (int i = 0; i < (int)words_and_emoticons.size(); i++)
 		{
 			String temp = words_and_emoticons[i];
 			std::transform(temp.begin(), temp.end(), temp.begin(), ::tolower);
@@ -241,36 +882,45 @@ namespace vader
 		}
 		if (bi.size() > 0)
 		{
-			for (int i = 0; i < sentiments.size(); i++) // Original vaderSentiment only uses first 'but' instance, TODO use more
+			for (int i = 0; i < (int)sentiments.size(); i++) // Original vaderSentiment only uses first 'but' instance, TODO use more
 			{
+				// scaled in place: inserting the scaled value and erasing the old one moved the whole tail every time
 				if (i < bi[0])
-				{
-					sentiments.insert(sentiments.begin() + i, sentiments[i] * 0.5); // wait isn't this a bit arbitrary/should it negate it or make it void or smth else
-					sentiments.erase(sentiments.begin() + i + 1);
-				}
+					sentiments[i] *= 0.5; // wait isn't this a bit arbitrary/should it negate it or make it void or smth else
 				else if (i > bi[0])
-				{
-					sentiments.insert(sentiments.begin() + i, sentiments[i] * 1.5); // wait isn't this a bit arbitrary/should it negate it or make it void or smth else
-					sentiments.erase(sentiments.begin() + i + 1);
-				}
+					sentiments[i] *= 1.5; // wait isn't this a bit arbitrary/should it negate it or make it void or smth else
 			}
 		}
 	}
 
-	double SentimentIntensityAnalyzer::_special_idioms_check(double valence, const std::vector<String> &words_and_emoticons, int i)
+	void SentimentIntensityAnalyzer::_but_check(int but_index, std::vector<double> &sentiments)
 	{
-		std::vector<String> words_and_emoticons_lower;
-		for (String word : words_and_emoticons)
+		// same weighting as above, scaling in place given the index of the first 'but' (-1 for none)
+		if (but_index < 0)
+			return;
+		for (int i = 0; i < (int)sentiments.size(); i++)
 		{
-			std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-			words_and_emoticons_lower.push_back(word);
+			if (i < but_index)
+				sentiments[i] *= 0.5;
+			else if (i > but_index)
+				sentiments[i] *= 1.5;
 		}
+	}
 
-		String onezero = words_and_emoticons_lower[i - 1] + u8' ' + words_and_emoticons_lower[i];
-		String twoonezero = words_and_emoticons_lower[i - 2] + u8' ' + onezero;
-		String twoone = words_and_emoticons_lower[i - 2] + u8' ' + words_and_emoticons_lower[i - 1];
-		String threetwoone = words_and_emoticons_lower[i - 3] + u8' ' + twoone;
-		String threetwo = words_and_emoticons_lower[i - 3] + u8' ' + words_and_emoticons_lower[i - 2];
+	double SentimentIntensityAnalyzer::_special_idioms_check(double valence, const std::vector<String> &words_and_emoticons, int i)
+	{
+		// only the few words around i are ever read, lowercasing the whole text for every word made this quadratic
+		auto lower = [&](int j) {
+			String word = words_and_emoticons[j];
+			std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+			return word;
+		};
+
+		String onezero = lower(i - 1) + u8' ' + lower(i);
+		String twoonezero = lower(i - 2) + u8' ' + onezero;
+		String twoone = lower(i - 2) + u8' ' + lower(i - 1);
+		String threetwoone = lower(i - 3) + u8' ' + twoone;
+		String threetwo = lower(i - 3) + u8' ' + lower(i - 2);
 		String sequences[5] = { onezero, twoonezero, twoone, threetwoone, threetwo };
 
 		for (String seq : sequences)
@@ -282,16 +932,19 @@ namespace vader
 			}
 		}
 
-		if (words_and_emoticons_lower.size() - 1 > i)
+		if ((int)words_and_emoticons.size() - 1 > i)
 		{
-			String zeroone = words_and_emoticons_lower[i] + u8' ' + words_and_emoticons_lower[i + 1];
+			String zeroone = lower(i) + u8' ' + lower(i + 1);
 			if (SPECIAL_CASES.count(zeroone))
 				valence = SPECIAL_CASES[zeroone];
-			if (words_and_emoticons_lower.size() - 1 > i + 1)
+			if ((int)words_and_emoticons.size() - 1 > i + 1)
 			{
 				String zeroonetwo = zeroone + u8' ' + words_and_emoticons[i + 2];
-				if (SPECIAL_CASES.count(zeroonetwo))
-					valence = SPECIAL_CASES[zeroone];
+				if (SPECIAL_CASES.count(zeroonetwo)) // (sic) reads zeroone, with find: operator[] would insert it into the shared table
+				{
+					std::unordered_map<String, double>::const_iterator special_case = SPECIAL_CASES.find(zeroone);
+					valence = special_case != SPECIAL_CASES.end() ? special_case->second : 0.0;
+				}
 			}
 		}
 
@@ -304,46 +957,131 @@ namespace vader
 		return valence;
 	}
 
-	double SentimentIntensityAnalyzer::_sentiment_laden_idioms_check(double valence, SentiText senti_text_lower) // TODO
+	double SentimentIntensityAnalyzer::_special_idioms_check(double valence, SentiText &sentitext, int i)
+	{
+		// same checks as above without lowercasing the whole text for every word
+		const std::vector<String> &words_and_emoticons = *sentitext.get_words_and_emoticons();
+		const std::vector<String> &words_and_emoticons_lower = *sentitext.get_l_words_and_emoticons();
+
+		String onezero = words_and_emoticons_lower[i - 1] + u8' ' + words_and_emoticons_lower[i];
+		String twoonezero = words_and_emoticons_lower[i - 2] + u8' ' + onezero;
+		String twoone = words_and_emoticons_lower[i - 2] + u8' ' + words_and_emoticons_lower[i - 1];
+		String threetwoone = words_and_emoticons_lower[i - 3] + u8' ' + twoone;
+		String threetwo = words_and_emoticons_lower[i - 3] + u8' ' + words_and_emoticons_lower[i - 2];
+		const String *sequences[5] = { &onezero, &twoonezero, &twoone, &threetwoone, &threetwo };
+
+		for (const String *seq : sequences)
+		{
+			std::unordered_map<String, double>::const_iterator special_case = SPECIAL_CASES.find(*seq);
+			if (special_case != SPECIAL_CASES.end())
+			{
+				valence = special_case->second;
+				break; // TODO: code without breaks
+			}
+		}
+
+		if ((int)words_and_emoticons_lower.size() - 1 > i)
+		{
+			String zeroone = words_and_emoticons_lower[i] + u8' ' + words_and_emoticons_lower[i + 1];
+			if (SPECIAL_CASES.count(zeroone))
+				valence = SPECIAL_CASES[zeroone];
+			if ((int)words_and_emoticons_lower.size() - 1 > i + 1)
+			{
+				String zeroonetwo = zeroone + u8' ' + words_and_emoticons[i + 2]; // not lowercased, as above
+				if (SPECIAL_CASES.count(zeroonetwo)) // (sic) reads zeroone, with find: operator[] would insert it into the shared table
+				{
+					std::unordered_map<String, double>::const_iterator special_case = SPECIAL_CASES.find(zeroone);
+					valence = special_case != SPECIAL_CASES.end() ? special_case->second : 0.0;
+				}
+			}
+		}
+
+		// check for booster/dampener bi-grams such as 'sort of' or 'kind of'
+		const String *n_grams[3] = { &threetwoone, &threetwo, &twoone };
+		for (const String *n_gram : n_grams)
+		{
+			std::unordered_map<String, double>::const_iterator booster = BOOSTER_DICT.find(*n_gram);
+			if (booster != BOOSTER_DICT.end())
+				valence = valence + booster->second;
+		}
+
+		return valence;
+	}
+
+	double SentimentIntensityAnalyzer::_sentiment_laden_idioms_check(double valence, SentiText /*senti_text_lower*/) // TODO
 	{
 		return valence;
 	}
 
 	double SentimentIntensityAnalyzer::_negation_check(double valence, const std::vector<String> &words_and_emoticons, int start_i, int i)
 	{
-		std::vector<String> words_and_emoticons_lower;
-		for (String word : words_and_emoticons)
-		{
+		// lowercases only the words it compares, as _special_idioms_check does
+		auto lower = [&](int j) {
+			String word = words_and_emoticons[j];
 			std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-			words_and_emoticons_lower.push_back(word);
-		}
+			return word;
+		};
 		std::vector<String> temp;
-		if (0 <= i - (start_i+1) && i - (start_i+1) < words_and_emoticons_lower.size())
-			temp.push_back(words_and_emoticons_lower[i - (start_i+1)]);
+		if (0 <= i - (start_i+1) && i - (start_i+1) < (int)words_and_emoticons.size())
+			temp.push_back(lower(i - (start_i+1)));
 		if (start_i == 0)
 		{
 			if (negated(temp)) // 1 word preceding lexicon word (w/o stopwords)
 				valence *= N_SCALAR;
 		}
 		else if (start_i == 1)
+		{
+			if (lower(i - 2) == u8"never" && (lower(i - 1) == u8"so" || lower(i - 1) == u8"this"))
+				valence *= 1.25;
+			else if (lower(i - 2) == u8"without" && lower(i - 1) == u8"doubt")
+				valence = valence;
+			else if (negated(temp)) // 2 words preceding the lexicon word position
+				valence *= N_SCALAR;
+		}
+		else if (start_i == 2)
+		{
+			if ((lower(i - 3) == u8"never" &&
+				(lower(i - 2) == u8"so" || lower(i - 2) == u8"this")) ||
+				(lower(i - 1) == u8"so" || lower(i - 1) == u8"this"))
+				valence *= 1.25;
+			else if (lower(i - 3) == u8"without" &&
+				(lower(i - 2) == u8"doubt" || lower(i - 1) == u8"doubt"))
+				valence = valence;
+			else if (negated(temp)) // 3 words preceding the lexicon word position
+				valence *= N_SCALAR;
+		}
+		return valence;
+	}
+
+	double SentimentIntensityAnalyzer::_negation_check(double valence, SentiText &sentitext, int start_i, int i)
+	{
+		// same checks as above, using the lowercased words and negations found by SentiText
+		const std::vector<String> &words_and_emoticons_lower = *sentitext.get_l_words_and_emoticons();
+		bool is_negated = sentitext.get_is_negated()[i - (start_i+1)];
+		if (start_i == 0)
+		{
+			if (is_negated) // 1 word preceding lexicon word (w/o stopwords)
+				valence *= N_SCALAR;
+		}
+		else if (start_i == 1)
 		{
 			if (words_and_emoticons_lower[i - 2] == u8"never" && (words_and_emoticons_lower[i - 1] == u8"so" || words_and_emoticons_lower[i - 1] == u8"this"))
 				valence *= 1.25;
 			else if (words_and_emoticons_lower[i - 2] == u8"without" && words_and_emoticons_lower[i - 1] == u8"doubt")
 				valence = valence;
-			else if (negated(temp)) // 2 words preceding the lexicon word position
+			else if (is_negated) // 2 words preceding the lexicon word position
 				valence *= N_SCALAR;
 		}
 		else if (start_i == 2)
 		{
-			if (words_and_emoticons_lower[i - 3] == u8"never" &&
-				(words_and_emoticons_lower[i - 2] == u8"so" || words_and_emoticons_lower[i - 2] == u8"this") ||
+			if ((words_and_emoticons_lower[i - 3] == u8"never" &&
+				(words_and_emoticons_lower[i - 2] == u8"so" || words_and_emoticons_lower[i - 2] == u8"this")) ||
 				(words_and_emoticons_lower[i - 1] == u8"so" || words_and_emoticons_lower[i - 1] == u8"this"))
 				valence *= 1.25;
 			else if (words_and_emoticons_lower[i - 3] == u8"without" &&
 				(words_and_emoticons_lower[i - 2] == u8"doubt" || words_and_emoticons_lower[i - 1] == u8"doubt"))
 				valence = valence;
-			else if (negated(temp)) // 3 words preceding the lexicon word position
+			else if (is_negated) // 3 words preceding the lexicon word position
 				valence *= N_SCALAR;
 		}
 		return valence;
@@ -359,9 +1097,13 @@ namespace vader
 	}
 
 	double SentimentIntensityAnalyzer::_amplify_ep(String text)
+	{
+		return _amplify_ep((int)std::count(text.begin(), text.end(), u8'!'));
+	}
+
+	double SentimentIntensityAnalyzer::_amplify_ep(int ep_count)
 	{
 		// check for added emphasis resulting from exclamation points (up to 4 of them)
-		int ep_count = std::count(text.begin(), text.end(), u8'!');
 		if (ep_count > 4)
 			ep_count = 4;
 		// (empirically derived mean sentiment intensity rating increase for exclamation points)
@@ -370,9 +1112,13 @@ namespace vader
 	}
 
 	double SentimentIntensityAnalyzer::_amplify_qm(String text)
+	{
+		return _amplify_qm((int)std::count(text.begin(), text.end(), u8'?'));
+	}
+
+	double SentimentIntensityAnalyzer::_amplify_qm(int qm_count)
 	{
 		// check for added emphasis resulting from question marks(2 or 3 + )
-		int qm_count = std::count(text.begin(), text.end(), u8'?');
 		double qm_amplifier = 0;
 		if (qm_count > 1)
 		{
@@ -385,12 +1131,12 @@ namespace vader
 		return qm_amplifier;
 	}
 
-	double * SentimentIntensityAnalyzer::_sift_sentiment_scores(std::vector<double> &sentiments)
+	void SentimentIntensityAnalyzer::_sift_sentiment_scores(const std::vector<double> &sentiments, double &pos_sum, double &neg_sum, double &neu_count)
 	{
 		// want separate positive versus negative sentiment scores
-		double pos_sum = 0.0;
-		double neg_sum = 0.0;
-		double neu_count = 0;
+		pos_sum = 0.0;
+		neg_sum = 0.0;
+		neu_count = 0;
 		for (double sentiment_score : sentiments)
 		{
 			if (sentiment_score > 0)
@@ -400,11 +1146,16 @@ namespace vader
 			else
 				neu_count += 1;
 		}
-		double packet[3] = { pos_sum, neg_sum, neu_count };
-		return packet;
 	}
 
 	Sentiment SentimentIntensityAnalyzer::score_valence(std::vector<double> &sentiments, String text)
+	{
+		// compute and add emphasis from punctuation in text
+		return this->_score_sentiments<DefaultRules>(sentiments, this->_punctuation_emphasis(text));
+	}
+
+	template <class Rules>
+	Sentiment SentimentIntensityAnalyzer::_score_sentiments(std::vector<double> &sentiments, double punct_emph_amplifier)
 	{
 		Sentiment sentiment_dict;
 
@@ -417,32 +1168,40 @@ namespace vader
 			double sum_s = 0;
 			for (double sentiment_score : sentiments)
 				sum_s += sentiment_score;
-			// compute and add emphasis from punctuation in text
-			double punct_emph_amplifier = this->_punctuation_emphasis(text);
 			if (sum_s > 0)
 				sum_s += punct_emph_amplifier;
 			else if (sum_s < 0)
 				sum_s -= punct_emph_amplifier;
 
 			sentiment_dict.compound = normalize(sum_s); // vader normalize
+			if constexpr (!Rules::sift)
+				return sentiment_dict;
 			// discriminate between positive, negative and neutral sentiment scores
-			double * packet = this->_sift_sentiment_scores(sentiments);
-			double pos_sum = packet[0];
-			double neg_sum = packet[1];
-			double neu_count = packet[2];
+			double pos_sum, neg_sum, neu_count;
+			this->_sift_sentiment_scores(sentiments, pos_sum, neg_sum, neu_count);
 
-			if (pos_sum > abs(neg_sum))
+			if (pos_sum > std::fabs(neg_sum))
 				pos_sum += punct_emph_amplifier;
-			else if (pos_sum < abs(neg_sum))
+			else if (pos_sum < std::fabs(neg_sum))
 				neg_sum -= punct_emph_amplifier;
 
-			double total = pos_sum + abs(neg_sum) + neu_count;
-			sentiment_dict.pos = abs(pos_sum / total);
-			sentiment_dict.neg = abs(neg_sum / total);
-			sentiment_dict.neu = abs(neu_count / total);
+			double total = pos_sum + std::fabs(neg_sum) + neu_count;
+			sentiment_dict.pos = std::fabs(pos_sum / total);
+			sentiment_dict.neg = std::fabs(neg_sum / total);
+			sentiment_dict.neu = std::fabs(neu_count / total);
 		}
 
 		return sentiment_dict;
 	}
 
+	// Scoring templates for the rule policies in vaderSentiment.hpp, a new policy needs its own line here
+	#define VADER_INSTANTIATE_RULES(Rules) \
+		template Sentiment SentimentIntensityAnalyzer::polarity_scores<Rules>(String text); \
+		template std::vector<Sentiment> SentimentIntensityAnalyzer::polarity_scores_all<Rules>(String text);
+
+	VADER_INSTANTIATE_RULES(DefaultRules)
+	VADER_INSTANTIATE_RULES(CompoundOnlyRules)
+	VADER_INSTANTIATE_RULES(PlainTextRules)
+	VADER_INSTANTIATE_RULES(PlainTextCompoundOnlyRules)
+	VADER_INSTANTIATE_RULES(LiteralRules)
 }
\ No newline at end of file
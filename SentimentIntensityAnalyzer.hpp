@@ -4,43 +4,154 @@
 #pragma execution_character_set("utf-8")
 
 #include "SentiText.hpp"
+#include "Lexicon.hpp"
+#include "Tracer.hpp"
+
+#include <chrono>
+#include <memory>
 
 namespace vader
 {
+    struct ScoreBudget // limits on the work spent on one text, 0 for no limit
+    {
+        size_t max_bytes = 0; // of the raw text
+        size_t max_tokens = 0; // tokens as SentiText splits them, after emoji substitution
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        bool truncate = true; // score the part within budget (cut at whitespace where possible), or return OVER_BUDGET unscored
+    };
+
+    enum class ScoreStatus
+    {
+        COMPLETE,
+        TRUNCATED, // only the first bytes/tokens were scored
+        OVER_BUDGET, // not scored, the text is over budget and truncation was not allowed
+        DEADLINE_EXCEEDED // not scored, the deadline passed first
+    };
+
+    struct BudgetedSentiment
+    {
+        Sentiment sentiment; // all 0 unless COMPLETE or TRUNCATED
+        ScoreStatus status = ScoreStatus::COMPLETE;
+        size_t bytes = 0; // raw bytes scored, up to the byte and token cuts (0 when not scored)
+        size_t bytes_total = 0;
+        size_t tokens = 0; // tokens scored
+    };
+
+    enum TokenRule : unsigned int // bits of TokenContribution::rules
+    {
+        RULE_CAPS = 1 << 0, // ALL CAPS emphasis of the word itself
+        RULE_BOOSTER = 1 << 1, // a booster/dampener among the 3 words before (scalar_inc_dec), or "never so/this" amplifying the word
+        RULE_NEGATION = 1 << 2, // a negation among the 3 words before, or "no" giving up its own valence to negate the next word
+        RULE_IDIOM = 1 << 3, // special case idioms and booster n-grams
+        RULE_LEAST = 1 << 4, // "least" before the word
+        RULE_BUT = 1 << 5, // weighted down before "but", up after it
+        RULE_MODIFIER = 1 << 6 // a lexicon word used as a booster or in "kind of", so it carries no valence
+    };
+
+    struct TokenContribution
+    {
+        String token;
+        double lexicon_valence = 0.0; // 0 if not in the lexicon
+        double valence = 0.0; // what the token adds to the sum, after every rule
+        unsigned int rules = 0; // TokenRule bits of the rules that changed the valence
+    };
+
+    struct ScoreExplanation // reuse one across calls, so its buffers are only allocated once
+    {
+        std::vector<TokenContribution> tokens;
+        double punctuation_emphasis = 0.0; // added to the sum (away from 0) for the !/? in the text, after the token valences
+    };
+
     class SentimentIntensityAnalyzer // Give a sentiment intensity score to sentences.
     {
     private: 
-        String m_lexicon_full_filepath;
+        struct Substitution // a part of the text _replace_emojis replaced: an emoji by its description, or spaces it dropped
+        {
+            size_t begin, end; // in the text
+            size_t result_begin, result_end; // in the result, empty for dropped spaces
+        };
+
+        std::vector<String> m_lexicon_full_filepaths;
         String m_emoji_full_filepath;
 
-        std::unordered_map<String, double> m_lexicon;
+        std::vector<std::unique_ptr<Lexicon>> m_lexicons; // m_lexicons[0] is the primary lexicon used by polarity_scores
         std::unordered_map<String, String> m_emojis;
 		std::vector<std::unordered_set<Char>> m_emoji_bank;
+        Tracer *m_tracer; // nullptr: no tracing
 
     public:
         SentimentIntensityAnalyzer(std::string lexicon_file="vader_lexicon.txt", std::string emoji_lexicon="emoji_utf8_lexicon.txt");
+        SentimentIntensityAnalyzer(std::vector<std::string> lexicon_files, std::string emoji_lexicon="emoji_utf8_lexicon.txt");
         ~SentimentIntensityAnalyzer();
 
+        int add_lexicon(std::string lexicon_file);
+        int lexicon_count();
+        Lexicon & get_lexicon(int i=0); // for profiling and loading hot sets
+        void set_tracer(Tracer *tracer); // records the stages of polarity_scores and batch boundaries, nullptr to stop
+        Tracer * get_tracer();
+
         Sentiment polarity_scores(String text);
-        void sentiment_valence(double valence, SentiText sentitext, String item, int i, std::vector<double> &sentiments);
+        template <class Rules> Sentiment polarity_scores(String text); // only the rules enabled by Rules are compiled in, see DefaultRules
+        std::vector<Sentiment> polarity_scores_all(String text); // one Sentiment per lexicon, in the order they were loaded
+        template <class Rules> std::vector<Sentiment> polarity_scores_all(String text);
+        Sentiment polarity_scores_parallel(String text, int threads=0); // same result as polarity_scores, for very large texts (0 threads: one per core)
+        // Pre-tokenized input, straight to the valence rules: the tokens of the emoji substituted text (replace_emojis) as
+        // split() (or SentiText) gives them, and the punctuation counts of that text (count_punctuation).
+        Sentiment polarity_scores(const std::vector<StringView> &tokens, PunctuationCounts punctuation);
+        String replace_emojis(String text); // emoji replaced by their descriptions, as polarity_scores does before tokenizing
+        Sentiment polarity_scores(const StringView *segments, size_t count); // the text held in several buffers (scatter-gather), never joined
+        Sentiment polarity_scores(String text, std::vector<String> *tokens, std::vector<double> *sentiments); // also gives each token's valence (after the "but" rule)
+        Sentiment polarity_scores(String text, ScoreExplanation &explanation); // also explains each token's valence, in the same pass
+        // Reference engine: the original word by word sentiment_valence and score_valence rules. Slow, but kept unchanged
+        // so that faster paths can be checked against it (see ShadowScorer). It shares the emoji substitution and the
+        // SentiText tokenization with polarity_scores, so differences in those stages are not caught that way; the
+        // ALL CAPS differential is computed again word by word (allcap_differential), not taken from SentiText.
+        Sentiment polarity_scores_reference(String text, std::vector<String> *tokens=nullptr, std::vector<double> *sentiments=nullptr);
+        // Bounded work per text, see ScoreBudget. The deadline is checked between stages and between blocks of tokens;
+        // the stages before tokenization are linear in the text, so max_bytes is what bounds them.
+        BudgetedSentiment polarity_scores(String text, const ScoreBudget &budget);
+        std::vector<Sentiment> polarity_scores_batch(const std::vector<String> &texts);
+        std::vector<BudgetedSentiment> polarity_scores_batch(const std::vector<String> &texts, const ScoreBudget &budget); // the byte and token limits apply to each text, the deadline to the whole batch
+        void sentiment_valence(double valence, SentiText &sentitext, String item, int i, std::vector<double> &sentiments, bool is_cap_diff);
 
     private:
         static int char_byte_count(Char val);
 
-        void make_lex_dict();
+        void make_lex_dict(std::string lexicon_file, Lexicon &lexicon);
         void make_emoji_dict();
+
+        template <class Rules> String _replace_emojis(const String &text, std::vector<Substitution> *substitutions=nullptr);
+        void _segment_tokens(const StringView *segments, size_t count, std::vector<String> &tokens, PunctuationCounts &punctuation);
+        template <class Rules> Sentiment _polarity_scores(String text, ScoreExplanation *explanation); // explanation only with Rules::explain
+        template <class Rules> Sentiment _score_lexicon(SentiText &sentitext, Lexicon &lexicon, std::vector<double> *token_sentiments=nullptr,
+            ScoreExplanation *explanation=nullptr);
+        template <class Rules> void _lexicon_valences(SentiText &sentitext, Lexicon &lexicon, std::vector<double> &sentiments, int begin, int end,
+            TokenContribution *contributions=nullptr);
+        static std::vector<size_t> _parallel_split_points(const String &text, int parts);
+        static size_t _byte_cut(const String &text, size_t max_bytes);
+        static size_t _token_cut(const String &text, size_t max_tokens);
+        static size_t _source_offset(const std::vector<Substitution> &substitutions, size_t result_offset);
+        static bool _past_deadline(const ScoreBudget &budget);
         
         double _least_check(double valence, const std::vector<String> &words_and_emoticons, int i);
+        static double _least_check(double valence, SentiText &sentitext, int i);
         static void _but_check(const std::vector<String> &words_and_emoticons, std::vector<double> &sentiments);
+        static void _but_check(int but_index, std::vector<double> &sentiments);
         static double _special_idioms_check(double valence, const std::vector<String> &words_and_emoticons, int i);
+        static double _special_idioms_check(double valence, SentiText &sentitext, int i);
         static double _sentiment_laden_idioms_check(double valence, SentiText senti_text_lower); // future work
         static double _negation_check(double valence, const std::vector<String> &words_and_emoticons, int start_i, int i);
+        static double _negation_check(double valence, SentiText &sentitext, int start_i, int i);
         
         double _punctuation_emphasis(String text);
         static double _amplify_ep(String text);
         static double _amplify_qm(String text);
         
-        static double * _sift_sentiment_scores(std::vector<double> &sentiments);
+        static double _amplify_ep(int ep_count);
+        static double _amplify_qm(int qm_count);
+        
+        static void _sift_sentiment_scores(const std::vector<double> &sentiments, double &pos_sum, double &neg_sum, double &neu_count);
         Sentiment score_valence(std::vector<double> &sentiments, String text);
+        template <class Rules> Sentiment _score_sentiments(std::vector<double> &sentiments, double punct_emph_amplifier);
     };
 }
@@ -0,0 +1,131 @@
+// implements ShadowScorer class
+#include "ShadowScorer.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace vader
+{
+	ShadowScorer::ShadowScorer(SentimentIntensityAnalyzer &analyzer, double sample_rate, double epsilon, int max_mismatches)
+		: m_analyzer(analyzer), m_sample_rate(std::min(std::max(sample_rate, 0.0), 1.0)), m_epsilon(epsilon),
+		  m_max_mismatches(std::max(max_mismatches, 0)), m_report_stream(nullptr), m_texts(0), m_sampled(0), m_mismatch_count(0)
+	{
+	}
+
+	ShadowScorer::~ShadowScorer()
+	{
+	}
+
+	void ShadowScorer::set_report_stream(std::ostream *report_stream)
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		this->m_report_stream = report_stream;
+	}
+
+	Sentiment ShadowScorer::polarity_scores(String text)
+	{
+		// Texts are sampled by count rather than at random, so exactly sample_rate of them are checked and a
+		// rerun over the same input checks the same texts
+		Sentiment res = this->m_analyzer.polarity_scores(text);
+		unsigned long long n = this->m_texts.fetch_add(1, std::memory_order_relaxed);
+		if (std::floor((n + 1) * this->m_sample_rate) > std::floor(n * this->m_sample_rate))
+			this->_compare(text, res);
+		return res;
+	}
+
+	bool ShadowScorer::check(String text)
+	{
+		this->m_texts.fetch_add(1, std::memory_order_relaxed);
+		return this->_compare(text, this->m_analyzer.polarity_scores(text));
+	}
+
+	ShadowStats ShadowScorer::get_stats()
+	{
+		ShadowStats stats;
+		stats.texts = this->m_texts.load(std::memory_order_relaxed);
+		stats.sampled = this->m_sampled.load(std::memory_order_relaxed);
+		stats.mismatches = this->m_mismatch_count.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	std::vector<ShadowMismatch> ShadowScorer::get_mismatches()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		return this->m_mismatches;
+	}
+
+	void ShadowScorer::reset()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		this->m_mismatches.clear();
+		this->m_texts = 0;
+		this->m_sampled = 0;
+		this->m_mismatch_count = 0;
+	}
+
+	std::string ShadowScorer::format_mismatch(const ShadowMismatch &mismatch)
+	{
+		// the text, both results, then one line per token with its valence from each engine ('*' where they differ)
+		char line[256];
+		std::string res = "vader shadow mismatch: \"" + from_u8string(mismatch.text) + "\"\n";
+		const Sentiment *results[2] = { &mismatch.reference, &mismatch.optimized };
+		const char *names[2] = { "reference", "optimized" };
+		for (int k = 0; k < 2; k++)
+		{
+			std::snprintf(line, sizeof(line), "  %s: compound %.17g neg %.17g neu %.17g pos %.17g\n",
+				names[k], results[k]->compound, results[k]->neg, results[k]->neu, results[k]->pos);
+			res += line;
+		}
+		for (size_t i = 0; i < mismatch.tokens.size(); i++)
+		{
+			const ShadowToken &token = mismatch.tokens[i];
+			std::snprintf(line, sizeof(line), "  %c %4zu %-24s %.17g %.17g\n", token.reference != token.optimized ? '*' : ' ',
+				i, from_u8string(token.token).c_str(), token.reference, token.optimized);
+			res += line;
+		}
+		return res;
+	}
+
+	bool ShadowScorer::_agrees(const Sentiment &reference, const Sentiment &optimized)
+	{
+		return std::fabs(reference.compound - optimized.compound) <= this->m_epsilon && std::fabs(reference.neg - optimized.neg) <= this->m_epsilon
+			&& std::fabs(reference.neu - optimized.neu) <= this->m_epsilon && std::fabs(reference.pos - optimized.pos) <= this->m_epsilon;
+	}
+
+	bool ShadowScorer::_compare(const String &text, const Sentiment &optimized)
+	{
+		this->m_sampled.fetch_add(1, std::memory_order_relaxed);
+		Sentiment reference = this->m_analyzer.polarity_scores_reference(text);
+		if (this->_agrees(reference, optimized))
+			return true;
+		this->m_mismatch_count.fetch_add(1, std::memory_order_relaxed);
+
+		// only mismatches pay for the token trace: both engines run again, keeping each token's valence
+		ShadowMismatch mismatch;
+		mismatch.text = text;
+		mismatch.reference = reference;
+		mismatch.optimized = optimized;
+		std::vector<String> reference_tokens, optimized_tokens;
+		std::vector<double> reference_sentiments, optimized_sentiments;
+		this->m_analyzer.polarity_scores_reference(text, &reference_tokens, &reference_sentiments);
+		this->m_analyzer.polarity_scores(text, &optimized_tokens, &optimized_sentiments);
+		size_t n = std::max(reference_tokens.size(), optimized_tokens.size());
+		for (size_t i = 0; i < n; i++)
+		{
+			ShadowToken token;
+			token.token = i < reference_tokens.size() ? reference_tokens[i] : optimized_tokens[i];
+			if (i < reference_sentiments.size())
+				token.reference = reference_sentiments[i];
+			if (i < optimized_sentiments.size())
+				token.optimized = optimized_sentiments[i];
+			mismatch.tokens.push_back(token);
+		}
+
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		if (this->m_report_stream)
+			*this->m_report_stream << format_mismatch(mismatch) << std::flush;
+		if (this->m_mismatches.size() < this->m_max_mismatches)
+			this->m_mismatches.push_back(mismatch);
+		return false;
+	}
+}
@@ -0,0 +1,71 @@
+// vader::ShadowScorer class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    struct ShadowToken
+    {
+        String token;
+        double reference = 0.0; // valence after the "but" rule
+        double optimized = 0.0;
+    };
+
+    struct ShadowMismatch
+    {
+        String text;
+        Sentiment reference;
+        Sentiment optimized;
+        std::vector<ShadowToken> tokens;
+    };
+
+    struct ShadowStats
+    {
+        unsigned long long texts = 0; // scored through the shadow scorer
+        unsigned long long sampled = 0; // also scored by the reference engine
+        unsigned long long mismatches = 0;
+    };
+
+    class ShadowScorer // Scores with the optimized engine and checks a sampled fraction of texts against the reference engine.
+    {
+    private:
+        SentimentIntensityAnalyzer &m_analyzer;
+        double m_sample_rate;
+        double m_epsilon;
+        size_t m_max_mismatches;
+        std::ostream *m_report_stream;
+
+        std::atomic<unsigned long long> m_texts;
+        std::atomic<unsigned long long> m_sampled;
+        std::atomic<unsigned long long> m_mismatch_count;
+        std::mutex m_lock; // guards m_mismatches and m_report_stream output
+        std::vector<ShadowMismatch> m_mismatches; // the first m_max_mismatches
+
+    public:
+        // sample_rate: fraction of texts checked (0 to 1), epsilon: largest difference allowed in each of compound, neg, neu and pos
+        ShadowScorer(SentimentIntensityAnalyzer &analyzer, double sample_rate=0.01, double epsilon=1e-9, int max_mismatches=100);
+        ~ShadowScorer();
+
+        void set_report_stream(std::ostream *report_stream); // every mismatch is written there as it is found, nullptr: none
+
+        Sentiment polarity_scores(String text); // always the optimized engine's result
+        bool check(String text); // compares this text regardless of sampling, true if the engines agree
+
+        ShadowStats get_stats();
+        std::vector<ShadowMismatch> get_mismatches();
+        void reset();
+
+        static std::string format_mismatch(const ShadowMismatch &mismatch);
+
+    private:
+        bool _agrees(const Sentiment &reference, const Sentiment &optimized);
+        bool _compare(const String &text, const Sentiment &optimized);
+    };
+}
@@ -0,0 +1,189 @@
+// implements Tracer class
+#include "Tracer.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+namespace vader
+{
+	static std::atomic<unsigned long long> next_tracer_id(1);
+	static std::mutex live_tracers_lock; // held while a tracer goes, so an ending thread never releases into a destroyed one
+	static std::unordered_map<unsigned long long, Tracer *> live_tracers;
+
+	struct ThreadTracerCache // the buffer this thread last used, saves taking the tracer's lock on every event
+	{
+		unsigned long long tracer_id = 0;
+		void *buffer = nullptr;
+		std::vector<std::pair<unsigned long long, void *>> owned; // every tracer's buffer this thread holds
+
+		~ThreadTracerCache()
+		{
+			// the thread is ending, give its buffers back for the next new thread to reuse
+			std::lock_guard<std::mutex> guard(live_tracers_lock);
+			for (std::pair<unsigned long long, void *> &owned_buffer : this->owned)
+			{
+				std::unordered_map<unsigned long long, Tracer *>::iterator tracer = live_tracers.find(owned_buffer.first);
+				if (tracer != live_tracers.end())
+					tracer->second->_release_thread_buffer((Tracer::ThreadBuffer *)owned_buffer.second);
+			}
+		}
+	};
+	static thread_local ThreadTracerCache thread_tracer_cache;
+
+	Tracer::Tracer(size_t events_per_thread, unsigned long long sample_every)
+		: m_id(next_tracer_id.fetch_add(1)), m_sample_every(std::max(sample_every, 1ULL)), m_start(std::chrono::steady_clock::now()), m_enabled(false)
+	{
+		size_t size = 2;
+		while (size < events_per_thread)
+			size *= 2;
+		this->m_mask = size - 1;
+		std::lock_guard<std::mutex> guard(live_tracers_lock);
+		live_tracers[this->m_id] = this;
+	}
+
+	Tracer::~Tracer()
+	{
+		std::lock_guard<std::mutex> guard(live_tracers_lock);
+		live_tracers.erase(this->m_id);
+	}
+
+	void Tracer::set_enabled(bool enabled)
+	{
+		this->m_enabled.store(enabled);
+	}
+
+	void Tracer::begin(const char *name)
+	{
+		// Sampling is decided by the outermost span, so a sampled text or batch is traced with all its stages
+		ThreadBuffer *buffer = this->_thread_buffer();
+		if (buffer->depth++ == 0)
+			buffer->sampled = buffer->roots++ % this->m_sample_every == 0;
+		if (buffer->sampled)
+			this->_record(buffer, name, 'B');
+	}
+
+	void Tracer::end(const char *name)
+	{
+		ThreadBuffer *buffer = this->_thread_buffer();
+		if (buffer->depth > 0)
+			buffer->depth--;
+		if (buffer->sampled)
+			this->_record(buffer, name, 'E');
+	}
+
+	void Tracer::set_thread_name(std::string name)
+	{
+		ThreadBuffer *buffer = this->_thread_buffer();
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		buffer->thread_name = name;
+	}
+
+	std::string Tracer::chrome_trace()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		std::string res = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		char line[512];
+		bool first = true;
+		auto add = [&]() {
+			if (!first)
+				res += ",";
+			res += "\n";
+			res += line;
+			first = false;
+		};
+		for (std::unique_ptr<ThreadBuffer> &buffer : this->m_buffers)
+		{
+			std::string thread_name = buffer->thread_name.empty() ? "thread " + std::to_string(buffer->thread_index) : buffer->thread_name;
+			std::string escaped;
+			for (char c : thread_name)
+				if (c == '"' || c == '\\')
+					escaped += '\\', escaped += c;
+				else if ((unsigned char)c >= 0x20)
+					escaped += c;
+			std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				buffer->thread_index, escaped.c_str());
+			add();
+
+			// the ring may have overwritten the begin events of the oldest spans, their end events are dropped too
+			unsigned long long written = buffer->written.load(std::memory_order_acquire);
+			unsigned long long oldest = written > this->m_mask + 1 ? written - (this->m_mask + 1) : 0;
+			int depth = 0;
+			for (unsigned long long i = oldest; i < written; i++)
+			{
+				const TraceEvent &event = buffer->events[i & this->m_mask];
+				if (event.phase == 'E' && depth == 0)
+					continue;
+				depth += event.phase == 'B' ? 1 : -1;
+				std::snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%llu.%03llu}",
+					event.name, event.phase, buffer->thread_index, event.time / 1000, event.time % 1000);
+				add();
+			}
+		}
+		res += "\n]}\n";
+		return res;
+	}
+
+	bool Tracer::write_chrome_trace(std::string trace_file)
+	{
+		std::ofstream out(trace_file, std::ios::binary | std::ios::trunc);
+		std::string trace = this->chrome_trace();
+		out.write(trace.data(), trace.size());
+		out.close();
+		return !out.fail();
+	}
+
+	void Tracer::clear()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		for (std::unique_ptr<ThreadBuffer> &buffer : this->m_buffers)
+			buffer->written.store(0);
+	}
+
+	Tracer::ThreadBuffer * Tracer::_thread_buffer()
+	{
+		if (thread_tracer_cache.tracer_id == this->m_id)
+			return (ThreadBuffer *)thread_tracer_cache.buffer;
+
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		ThreadBuffer *&buffer = this->m_thread_buffers[std::this_thread::get_id()];
+		if (!buffer && !this->m_free_buffers.empty())
+		{
+			// the ring of a thread that ended, its events are kept and this thread's follow them
+			buffer = this->m_free_buffers.back();
+			this->m_free_buffers.pop_back();
+			buffer->thread_name.clear();
+			buffer->depth = 0;
+			buffer->sampled = false;
+			thread_tracer_cache.owned.push_back({ this->m_id, buffer });
+		}
+		else if (!buffer)
+		{
+			this->m_buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+			buffer = this->m_buffers.back().get();
+			buffer->events.reset(new TraceEvent[this->m_mask + 1]);
+			buffer->written.store(0, std::memory_order_relaxed);
+			buffer->thread_index = this->m_buffers.size();
+			thread_tracer_cache.owned.push_back({ this->m_id, buffer });
+		}
+		thread_tracer_cache.tracer_id = this->m_id;
+		thread_tracer_cache.buffer = buffer;
+		return buffer;
+	}
+
+	void Tracer::_release_thread_buffer(ThreadBuffer *buffer)
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		this->m_thread_buffers.erase(std::this_thread::get_id());
+		this->m_free_buffers.push_back(buffer);
+	}
+
+	void Tracer::_record(ThreadBuffer *buffer, const char *name, char phase)
+	{
+		unsigned long long i = buffer->written.load(std::memory_order_relaxed);
+		TraceEvent &event = buffer->events[i & this->m_mask];
+		event.name = name;
+		event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->m_start).count();
+		event.phase = phase;
+		buffer->written.store(i + 1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,118 @@
+// vader::Tracer class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vader
+{
+    struct TraceEvent
+    {
+        const char *name; // a string literal, only the pointer is kept
+        unsigned long long time; // nanoseconds since the tracer was made
+        char phase; // 'B' begin, 'E' end, as in the Chrome trace event format
+    };
+
+    class Tracer // Records begin/end events per thread into lock-free ring buffers, and writes them as Chrome trace event JSON.
+    {
+    private:
+        struct ThreadBuffer // written only by its thread
+        {
+            std::unique_ptr<TraceEvent[]> events;
+            std::atomic<unsigned long long> written; // events ever written, the ring keeps the last mask + 1
+            int thread_index;
+            std::string thread_name; // guarded by m_lock
+            int depth = 0; // open spans
+            bool sampled = false; // the outermost open span is sampled
+            unsigned long long roots = 0; // outermost spans begun
+        };
+
+        const unsigned long long m_id; // tells tracers apart in the per-thread buffer cache
+        size_t m_mask;
+        unsigned long long m_sample_every;
+        std::chrono::steady_clock::time_point m_start;
+        std::atomic<bool> m_enabled;
+        std::mutex m_lock; // guards m_buffers, m_free_buffers and the thread names
+        std::vector<std::unique_ptr<ThreadBuffer>> m_buffers; // kept after their thread ends, until the tracer goes
+        std::vector<ThreadBuffer *> m_free_buffers; // of threads that ended, given to the next new thread
+        std::unordered_map<std::thread::id, ThreadBuffer *> m_thread_buffers;
+
+        friend struct ThreadTracerCache;
+
+    public:
+        // events_per_thread: ring size (rounded up to a power of two), the oldest events are overwritten. A thread that
+        // ends gives its ring to the next new thread, which continues on the same track of the trace, so there are at most
+        // as many rings as threads that traced at the same time.
+        // sample_every: record one in this many outermost spans on each thread, and everything nested in it.
+        Tracer(size_t events_per_thread=1 << 16, unsigned long long sample_every=1);
+        ~Tracer();
+
+        void set_enabled(bool enabled); // starts off, a disabled tracer costs one relaxed load per span
+        bool is_enabled() const
+        {
+            return this->m_enabled.load(std::memory_order_relaxed);
+        }
+
+        void begin(const char *name); // on the calling thread, prefer TraceSpan
+        void end(const char *name);
+        void set_thread_name(std::string name); // of the calling thread, shown by trace viewers
+
+        // Chrome trace event JSON (open in Perfetto or chrome://tracing). Only call these, and clear, while no traced
+        // work is running: the rings are not locked, so events being written at the same time can be torn.
+        std::string chrome_trace();
+        bool write_chrome_trace(std::string trace_file);
+        void clear();
+
+    private:
+        ThreadBuffer * _thread_buffer();
+        void _release_thread_buffer(ThreadBuffer *buffer); // on the thread that is ending
+        void _record(ThreadBuffer *buffer, const char *name, char phase);
+    };
+
+    class TraceSpan // Begins a span on construction and ends it on destruction (or at end/next). Free when tracer is nullptr.
+    {
+    private:
+        Tracer *m_tracer; // nullptr when nothing was begun
+        const char *m_name;
+
+    public:
+        TraceSpan(Tracer *tracer, const char *name)
+            : m_tracer(tracer && tracer->is_enabled() ? tracer : nullptr), m_name(name)
+        {
+            if (this->m_tracer)
+                this->m_tracer->begin(name);
+        }
+
+        ~TraceSpan()
+        {
+            this->end();
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan & operator=(const TraceSpan &) = delete;
+
+        void end()
+        {
+            if (this->m_tracer)
+                this->m_tracer->end(this->m_name);
+            this->m_tracer = nullptr;
+        }
+
+        void next(Tracer *tracer, const char *name) // ends this span and begins the next stage
+        {
+            this->end();
+            this->m_tracer = tracer && tracer->is_enabled() ? tracer : nullptr;
+            this->m_name = name;
+            if (this->m_tracer)
+                this->m_tracer->begin(name);
+        }
+    };
+}
@@ -0,0 +1,417 @@
+// implements WorkloadCapture and WorkloadReplay classes
+#include "WorkloadCapture.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace vader
+{
+	static const char WORKLOAD_MAGIC[8] = { 'V', 'A', 'D', 'E', 'R', 'W', 'L', '1' };
+
+	WorkloadCapture::WorkloadCapture(SentimentIntensityAnalyzer &analyzer, double sample_rate, CaptureRedaction redaction, unsigned long long key, size_t max_bytes)
+		: m_analyzer(analyzer), m_sample_rate(std::min(std::max(sample_rate, 0.0), 1.0)), m_redaction(redaction), m_key(key), m_max_bytes(max_bytes),
+		  m_open(false), m_texts(0), m_captured(0), m_bytes(0)
+	{
+	}
+
+	WorkloadCapture::~WorkloadCapture()
+	{
+		this->close();
+	}
+
+	bool WorkloadCapture::open(std::string log_file)
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		if (this->m_log.is_open())
+			this->m_log.close();
+		this->m_error.clear();
+		this->m_log.open(log_file, std::ios::binary | std::ios::trunc);
+		if (!this->m_log)
+		{
+			this->m_error = "cannot open " + log_file;
+			return false;
+		}
+
+		std::string header(WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+		_put_varint(header, (unsigned long long)this->m_redaction);
+		_put_varint(header, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+		this->m_log.write(header.data(), header.size());
+		if (!this->m_log)
+		{
+			this->m_error = "cannot write " + log_file;
+			return false;
+		}
+		this->m_bytes = header.size();
+		this->m_last = std::chrono::steady_clock::now();
+		this->m_open = true;
+		return true;
+	}
+
+	bool WorkloadCapture::close()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		this->m_open = false;
+		if (!this->m_log.is_open())
+			return this->m_error.empty();
+		this->m_log.close();
+		if (this->m_log.fail() && this->m_error.empty())
+			this->m_error = "cannot write the workload log";
+		return this->m_error.empty();
+	}
+
+	Sentiment WorkloadCapture::polarity_scores(String text)
+	{
+		this->capture(text);
+		return this->m_analyzer.polarity_scores(text);
+	}
+
+	void WorkloadCapture::capture(const String &text)
+	{
+		// Sampled by count like ShadowScorer, so exactly sample_rate of the texts are captured
+		unsigned long long n = this->m_texts.fetch_add(1, std::memory_order_relaxed);
+		if (!this->m_open.load(std::memory_order_relaxed) || std::floor((n + 1) * this->m_sample_rate) <= std::floor(n * this->m_sample_rate))
+			return;
+		if (this->m_redaction == CaptureRedaction::NONE)
+			this->_write(text);
+		else
+			this->_write(this->redact(text));
+	}
+
+	struct LetterRange // a redacted letter is replaced by one from its own range, so it keeps its script, case and UTF-8 length
+	{
+		unsigned int first, last, step;
+	};
+
+	static const LetterRange LETTER_RANGES[] =
+	{
+		{ 0x30, 0x39, 1 }, { 0x41, 0x5A, 1 }, { 0x61, 0x7A, 1 }, // ASCII digits, capitals, small letters
+		{ 0xC0, 0xD6, 1 }, { 0xD8, 0xDE, 1 }, { 0xDF, 0xF6, 1 }, { 0xF8, 0xFF, 1 }, // Latin-1 capitals, small letters (not × and ÷)
+		{ 0x100, 0x17E, 2 }, { 0x101, 0x17F, 2 }, // Latin Extended-A, capitals at even code points (mostly)
+		{ 0x391, 0x3A1, 1 }, { 0x3A3, 0x3A9, 1 }, { 0x3B1, 0x3C9, 1 }, // Greek capitals, small letters
+		{ 0x400, 0x42F, 1 }, { 0x430, 0x45F, 1 }, // Cyrillic capitals, small letters
+		{ 0x5D0, 0x5EA, 1 }, { 0x621, 0x64A, 1 }, { 0x660, 0x669, 1 }, // Hebrew, Arabic letters and digits
+		{ 0x905, 0x939, 1 }, { 0xE01, 0xE2E, 1 }, // Devanagari, Thai
+		{ 0x3041, 0x3096, 1 }, { 0x30A1, 0x30FA, 1 }, { 0x4E00, 0x9FFF, 1 }, { 0xAC00, 0xD7A3, 1 } // kana, CJK ideographs, Hangul
+	};
+
+	static int letter_range(unsigned int code_point) // index in LETTER_RANGES, -1 for characters that are kept
+	{
+		for (int i = 0; i < (int)(sizeof(LETTER_RANGES) / sizeof(LETTER_RANGES[0])); i++)
+		{
+			const LetterRange &range = LETTER_RANGES[i];
+			if (code_point >= range.first && code_point <= range.last && (code_point - range.first) % range.step == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	static size_t decode_utf8(const String &text, size_t i, unsigned int &code_point) // the character's length, 1 for a broken sequence
+	{
+		Char c = text[i];
+		size_t length = c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+		code_point = length == 1 ? c : length == 2 ? c & 0x1F : length == 3 ? c & 0x0F : c & 0x07;
+		for (size_t k = 1; k < length; k++)
+		{
+			if (i + k >= text.length() || (Char(text[i + k]) & 0xC0) != 0x80)
+			{
+				code_point = c >= 0x80 ? 0xFFFD : c; // kept as it is
+				return 1;
+			}
+			code_point = (code_point << 6) | (Char(text[i + k]) & 0x3F);
+		}
+		return length;
+	}
+
+	String WorkloadCapture::redact(const String &text)
+	{
+		// Each letter or digit is replaced by one of the same script and case (see LETTER_RANGES), everything else
+		// (whitespace, punctuation, symbols, emoticons of the lexicon, and every emoji of the emoji lexicon) is kept, so the redacted
+		// text has the lengths, capitalization, punctuation and emoji density of the real one. A character followed by
+		// an emoji presentation selector or a combining keycap (the digit of 1️⃣) is part of an emoji and kept too.
+		// Each word's replacement comes from a keyed hash of the word.
+		String res = text;
+		size_t n = text.length();
+		std::vector<int> ranges(n, -1); // LETTER_RANGES index of the letter or digit starting at each byte, -1 for bytes kept as they are
+		std::vector<size_t> char_lengths(n, 1);
+		int previous = -1; // byte where the previous character starts
+		for (size_t i = 0; i < n;)
+		{
+			unsigned int code_point;
+			size_t length = decode_utf8(text, i, code_point);
+			if ((code_point == 0xFE0F || code_point == 0x20E3) && previous >= 0)
+				ranges[previous] = -1;
+			ranges[i] = letter_range(code_point);
+			char_lengths[i] = length;
+			previous = i;
+			i += length;
+		}
+
+		for (size_t begin = 0; begin < n;)
+		{
+			if (std::isspace(Char(text[begin])))
+			{
+				begin++;
+				continue;
+			}
+			size_t end = begin;
+			while (end < n && !std::isspace(Char(text[end])))
+				end++;
+			String token = text.substr(begin, end - begin);
+			if ((this->m_redaction == CaptureRedaction::HASH_KEEP_RULE_WORDS && this->_is_rule_word(token)) || this->_is_emoticon(token))
+			{
+				begin = end;
+				continue;
+			}
+
+			// the words of the token: runs of letters and digits between its punctuation
+			for (size_t i = begin; i < end;)
+			{
+				if (ranges[i] < 0)
+				{
+					i += char_lengths[i];
+					continue;
+				}
+				size_t word_end = i;
+				while (word_end < end && ranges[word_end] >= 0)
+					word_end += char_lengths[word_end];
+				String word = text.substr(i, word_end - i);
+				if (this->m_redaction == CaptureRedaction::HASH_KEEP_RULE_WORDS && this->_is_rule_word(word))
+				{
+					i = word_end;
+					continue;
+				}
+
+				unsigned long long state = 14695981039346656037ULL ^ this->m_key; // FNV-1a of the word, keyed
+				for (Char c : word)
+					state = (state ^ c) * 1099511628211ULL;
+				for (size_t k = i; k < word_end; k += char_lengths[k])
+				{
+					state += 0x9E3779B97F4A7C15ULL; // splitmix64
+					unsigned long long r = state;
+					r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+					r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+					r ^= r >> 31;
+					const LetterRange &range = LETTER_RANGES[ranges[k]];
+					unsigned int code_point = range.first + r % ((range.last - range.first) / range.step + 1) * range.step;
+					if (char_lengths[k] == 1)
+						res[k] = Char(code_point);
+					else if (char_lengths[k] == 2)
+					{
+						res[k] = Char(0xC0 | (code_point >> 6));
+						res[k + 1] = Char(0x80 | (code_point & 0x3F));
+					}
+					else
+					{
+						res[k] = Char(0xE0 | (code_point >> 12));
+						res[k + 1] = Char(0x80 | ((code_point >> 6) & 0x3F));
+						res[k + 2] = Char(0x80 | (code_point & 0x3F));
+					}
+				}
+				i = word_end;
+			}
+			begin = end;
+		}
+		return res;
+	}
+
+	CaptureStats WorkloadCapture::get_stats()
+	{
+		CaptureStats stats;
+		stats.texts = this->m_texts.load(std::memory_order_relaxed);
+		stats.captured = this->m_captured.load(std::memory_order_relaxed);
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		stats.bytes = this->m_bytes;
+		return stats;
+	}
+
+	std::string WorkloadCapture::get_error()
+	{
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		return this->m_error;
+	}
+
+	void WorkloadCapture::_write(const String &text)
+	{
+		std::string record;
+		record.reserve(text.length() + 20);
+		std::lock_guard<std::mutex> guard(this->m_lock);
+		if (!this->m_open.load(std::memory_order_relaxed))
+			return;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		_put_varint(record, std::chrono::duration_cast<std::chrono::microseconds>(now - this->m_last).count());
+		_put_varint(record, text.length());
+		record.append(text.begin(), text.end());
+		if (this->m_max_bytes > 0 && this->m_bytes + record.size() > this->m_max_bytes)
+		{
+			this->m_open = false; // full, later texts are not captured either
+			this->m_log.flush();
+			return;
+		}
+		this->m_log.write(record.data(), record.size());
+		if (!this->m_log)
+		{
+			this->m_error = "cannot write the workload log";
+			this->m_open = false;
+			return;
+		}
+		this->m_last = now;
+		this->m_bytes += record.size();
+		this->m_captured.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	bool WorkloadCapture::_is_rule_word(String word)
+	{
+		std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+		return this->m_analyzer.get_lexicon().count(word) || NEGATE.count(word) || BOOSTER_DICT.count(word);
+	}
+
+	bool WorkloadCapture::_is_emoticon(const String &token)
+	{
+		// a lexicon entry with ASCII punctuation in it, such as :D or <3
+		return this->m_analyzer.get_lexicon().count(token) && std::any_of(token.begin(), token.end(), [](Char c) { return c < 0x80 && std::ispunct(c); });
+	}
+
+	void WorkloadCapture::_put_varint(std::string &out, unsigned long long value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(char(0x80 | (value & 0x7F)));
+			value >>= 7;
+		}
+		out.push_back(char(value));
+	}
+
+	WorkloadReplay::WorkloadReplay(SentimentIntensityAnalyzer &analyzer)
+		: m_analyzer(analyzer), m_redaction(CaptureRedaction::NONE)
+	{
+	}
+
+	WorkloadReplay::~WorkloadReplay()
+	{
+	}
+
+	bool WorkloadReplay::load(std::string log_file)
+	{
+		this->m_records.clear();
+		this->m_error.clear();
+		std::ifstream in(log_file, std::ios::binary);
+		if (!in)
+		{
+			this->m_error = "cannot open " + log_file;
+			return false;
+		}
+		char magic[sizeof(WORKLOAD_MAGIC)];
+		unsigned long long redaction, start_time;
+		if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) != 0
+			|| !_get_varint(in, redaction) || !_get_varint(in, start_time) || redaction > (unsigned long long)CaptureRedaction::HASH_KEEP_RULE_WORDS)
+		{
+			this->m_error = log_file + " is not a workload log";
+			return false;
+		}
+		this->m_redaction = (CaptureRedaction)redaction;
+
+		// a record cut off at the end (the capturing process stopped mid write) is dropped, and so is everything from a
+		// length longer than the rest of the file (a damaged log), before any memory is allocated for it
+		std::streamoff position = in.tellg();
+		in.seekg(0, std::ios::end);
+		std::streamoff file_size = in.tellg();
+		in.seekg(position);
+		unsigned long long offset = 0, delta, length;
+		while (_get_varint(in, delta) && _get_varint(in, length))
+		{
+			if (length > (unsigned long long)(file_size - in.tellg()))
+				break;
+			WorkloadRecord record;
+			offset += delta;
+			record.offset = offset;
+			record.text.resize(length);
+			if (length > 0 && !in.read((char *)&record.text[0], length))
+				break;
+			this->m_records.push_back(std::move(record));
+		}
+		return true;
+	}
+
+	const std::vector<WorkloadRecord> & WorkloadReplay::get_records()
+	{
+		return this->m_records;
+	}
+
+	CaptureRedaction WorkloadReplay::get_redaction()
+	{
+		return this->m_redaction;
+	}
+
+	ReplayReport WorkloadReplay::replay(double speed, int repeats)
+	{
+		ReplayReport report;
+		std::vector<double> latencies;
+		latencies.reserve(this->m_records.size() * std::max(repeats, 0));
+		unsigned long long span = this->m_records.empty() ? 0 : this->m_records.back().offset; // repeats follow each other at recorded rate
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			for (WorkloadRecord &record : this->m_records)
+			{
+				std::chrono::steady_clock::time_point arrival;
+				if (speed > 0)
+				{
+					// open loop: the text arrives at its recorded time whether or not the texts before it are done
+					arrival = start + std::chrono::microseconds((long long)((repeat * span + record.offset) / speed));
+					std::this_thread::sleep_until(arrival);
+				}
+				else
+					arrival = std::chrono::steady_clock::now();
+				this->m_analyzer.polarity_scores(record.text);
+				latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - arrival).count());
+				report.bytes += record.text.length();
+			}
+		}
+		report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		report.texts = latencies.size();
+		if (report.seconds > 0)
+		{
+			report.texts_per_second = report.texts / report.seconds;
+			report.mb_per_second = report.bytes / 1e6 / report.seconds;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		report.latency_p50 = _percentile(latencies, 0.5);
+		report.latency_p90 = _percentile(latencies, 0.9);
+		report.latency_p99 = _percentile(latencies, 0.99);
+		report.latency_p999 = _percentile(latencies, 0.999);
+		report.latency_max = latencies.empty() ? 0.0 : latencies.back();
+		return report;
+	}
+
+	std::string WorkloadReplay::get_error()
+	{
+		return this->m_error;
+	}
+
+	bool WorkloadReplay::_get_varint(std::istream &in, unsigned long long &value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			int c = in.get();
+			if (c == EOF)
+				return false;
+			value |= (unsigned long long)(c & 0x7F) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	double WorkloadReplay::_percentile(const std::vector<double> &sorted, double fraction)
+	{
+		// nearest rank
+		if (sorted.empty())
+			return 0.0;
+		size_t rank = (size_t)std::ceil(fraction * sorted.size());
+		return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+	}
+}
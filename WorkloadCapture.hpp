@@ -0,0 +1,122 @@
+// vader::WorkloadCapture class header
+
+#pragma once
+#pragma execution_character_set("utf-8")
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
+#include "SentimentIntensityAnalyzer.hpp"
+
+namespace vader
+{
+    // Workload log format: the magic "VADERWL1", then varints for the redaction mode and the wall clock time capture
+    // started (microseconds since the Unix epoch), then one record per captured text: varints for the microseconds since
+    // the previous record (since the start for the first) and the text's length in bytes, then the text itself.
+    // Varints are LEB128: 7 bits per byte, low bits first, high bit set on every byte but the last.
+
+    enum class CaptureRedaction
+    {
+        NONE, // texts are logged as they are
+        HASH, // every word is replaced by a keyed hash with the same length, script and case; emoji, emoticons and punctuation are kept
+        HASH_KEEP_RULE_WORDS // as HASH, but words VADER has rules for (lexicon, negations, boosters) are kept, so the rules fire as in the real texts
+    };
+
+    struct CaptureStats
+    {
+        unsigned long long texts = 0; // seen by the capture
+        unsigned long long captured = 0; // sampled and written to the log
+        unsigned long long bytes = 0; // written to the log, including the header
+    };
+
+    class WorkloadCapture // Samples the texts scored in production into a compact binary log, for replay (see WorkloadReplay).
+    {
+    private:
+        SentimentIntensityAnalyzer &m_analyzer;
+        double m_sample_rate;
+        CaptureRedaction m_redaction;
+        unsigned long long m_key;
+        size_t m_max_bytes;
+
+        std::atomic<bool> m_open;
+        std::atomic<unsigned long long> m_texts;
+        std::atomic<unsigned long long> m_captured;
+        std::mutex m_lock; // guards the log file and everything below
+        std::ofstream m_log;
+        unsigned long long m_bytes;
+        std::chrono::steady_clock::time_point m_last;
+        std::string m_error;
+
+    public:
+        // sample_rate: fraction of texts captured (0 to 1), key: for HASH redaction (the same word always gets the same
+        // hash under one key), max_bytes: capture stops once the log reaches this size (0 for no limit)
+        WorkloadCapture(SentimentIntensityAnalyzer &analyzer, double sample_rate=0.01, CaptureRedaction redaction=CaptureRedaction::NONE,
+            unsigned long long key=0, size_t max_bytes=0);
+        ~WorkloadCapture(); // close()
+
+        bool open(std::string log_file); // truncates log_file and writes the header
+        bool close();
+
+        Sentiment polarity_scores(String text); // scores the text, capturing a sampled fraction
+        void capture(const String &text); // the hook for texts scored elsewhere, sampled the same way
+
+        String redact(const String &text);
+        CaptureStats get_stats();
+        std::string get_error();
+
+    private:
+        void _write(const String &text);
+        bool _is_rule_word(String word);
+        bool _is_emoticon(const String &token);
+        static void _put_varint(std::string &out, unsigned long long value);
+    };
+
+    struct WorkloadRecord
+    {
+        unsigned long long offset = 0; // microseconds since the start of the capture
+        String text;
+    };
+
+    struct ReplayReport
+    {
+        unsigned long long texts = 0;
+        unsigned long long bytes = 0;
+        double seconds = 0.0;
+        double texts_per_second = 0.0;
+        double mb_per_second = 0.0; // MB of 10^6 bytes, as CorpusProgress
+        // per text latencies in microseconds: service time at maximum rate, time from the recorded arrival to the result at recorded rate
+        double latency_p50 = 0.0;
+        double latency_p90 = 0.0;
+        double latency_p99 = 0.0;
+        double latency_p999 = 0.0;
+        double latency_max = 0.0;
+    };
+
+    class WorkloadReplay // Reads workload logs and feeds them through an analyzer, timing every text.
+    {
+    private:
+        SentimentIntensityAnalyzer &m_analyzer;
+        std::vector<WorkloadRecord> m_records;
+        CaptureRedaction m_redaction;
+        std::string m_error;
+
+    public:
+        WorkloadReplay(SentimentIntensityAnalyzer &analyzer);
+        ~WorkloadReplay();
+
+        bool load(std::string log_file); // replaces the records loaded before
+        const std::vector<WorkloadRecord> & get_records();
+        CaptureRedaction get_redaction();
+
+        // speed: 0 replays as fast as possible, otherwise at the recorded arrival times scaled by 1 / speed (1 for the
+        // recorded rate). Arrivals are not delayed by slow texts, so a backlog shows in the latencies.
+        ReplayReport replay(double speed=0.0, int repeats=1);
+        std::string get_error();
+
+    private:
+        static bool _get_varint(std::istream &in, unsigned long long &value);
+        static double _percentile(const std::vector<double> &sorted, double fraction);
+    };
+}
@@ -0,0 +1,119 @@
+// Scaling regression test: scores generated texts of growing length for several input shapes, fits the growth of the
+// run time (the slope of log(time) over log(length)) and fails if any of them grows faster than linearly. A family is
+// measured again when its fit is over the limit, and only fails if every attempt is: load on the machine can slow a few
+// of the timings of one attempt, but an actual super-linear cost shows up every time.
+// Build it like test.cpp, with optimizations on (-O2), and run it from the directory holding the lexicon files.
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "vaderSentiment.hpp"
+#include "SentiText.hpp"
+#include "SentimentIntensityAnalyzer.hpp"
+
+struct InputFamily
+{
+	std::string name;
+	String unit; // the text of length n is this repeated n times
+};
+
+static double seconds_per_call(const std::function<void()> &score)
+{
+	// best of 3 rounds, each repeating the call for at least 20 ms
+	double best = 1e30;
+	for (int round = 0; round < 3; round++)
+	{
+		int calls = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double elapsed = 0;
+		do
+		{
+			score();
+			calls++;
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (elapsed < 0.02);
+		best = std::min(best, elapsed / calls);
+	}
+	return best;
+}
+
+static double growth_exponent(const std::vector<double> &lengths, const std::vector<double> &times)
+{
+	// least squares slope of log(time) over log(length): 1 for linear growth, 2 for quadratic
+	double mean_x = 0, mean_y = 0;
+	for (size_t i = 0; i < lengths.size(); i++)
+	{
+		mean_x += std::log(lengths[i]) / lengths.size();
+		mean_y += std::log(times[i]) / lengths.size();
+	}
+	double sxy = 0, sxx = 0;
+	for (size_t i = 0; i < lengths.size(); i++)
+	{
+		sxy += (std::log(lengths[i]) - mean_x) * (std::log(times[i]) - mean_y);
+		sxx += (std::log(lengths[i]) - mean_x) * (std::log(lengths[i]) - mean_x);
+	}
+	return sxy / sxx;
+}
+
+int main()
+{
+	const double max_exponent = 1.3; // linear growth plus room for cache effects and timer noise
+	const int max_attempts = 3;
+	const int min_repeats = 256, max_repeats = 8192;
+	const double max_seconds = 0.5; // per call, lengths stop growing once a call takes longer
+
+	std::vector<InputFamily> families =
+	{
+		{ "plain words", u8"the book was good and the plot was not bad at all " },
+		{ "many buts", u8"good but bad but " },
+		{ "negations and idioms", u8"never so good without doubt not the shit at least kind of bad " },
+		{ "dense emoji", u8"\xF0\x9F\x98\x81 \xF0\x9F\x92\x98\xF0\x9F\x92\x8B good " },
+		{ "punctuation runs", u8"GREAT!!!!!!!!!!!!!!!! what???????? " },
+		{ "one long token", u8"ab!?" },
+	};
+
+	vader::SentimentIntensityAnalyzer vader;
+	std::vector<std::pair<std::string, std::function<vader::Sentiment(const String &)>>> engines =
+	{
+		{ "polarity_scores", [&](const String &text) { return vader.polarity_scores(text); } },
+		{ "polarity_scores_reference", [&](const String &text) { return vader.polarity_scores_reference(text); } },
+	};
+
+	bool passed = true;
+	for (std::pair<std::string, std::function<vader::Sentiment(const String &)>> &engine : engines)
+	{
+		for (InputFamily &family : families)
+		{
+			std::vector<double> lengths, times;
+			double exponent = 0;
+			int attempt = 0;
+			do
+			{
+				lengths.clear();
+				times.clear();
+				for (int repeats = min_repeats; repeats <= max_repeats; repeats *= 2)
+				{
+					String text;
+					for (int i = 0; i < repeats; i++)
+						text += family.unit;
+					lengths.push_back(text.length());
+					times.push_back(seconds_per_call([&]() { engine.second(text); }));
+					if (times.back() > max_seconds && lengths.size() >= 3)
+						break; // already far too slow, the fit over the lengths so far shows it
+				}
+				exponent = growth_exponent(lengths, times);
+				attempt++;
+			} while (exponent > max_exponent && attempt < max_attempts);
+			bool ok = exponent <= max_exponent;
+			passed = passed && ok;
+			std::cout << (ok ? "ok   " : "FAIL ") << engine.first << ", " << family.name << ": time ~ length^" << exponent
+				<< " (" << times.front() * 1e3 << " ms at " << lengths.front() << " bytes, " << times.back() * 1e3 << " ms at " << lengths.back() << " bytes"
+				<< (attempt > 1 ? ", attempt " + std::to_string(attempt) : "") << ")" << std::endl;
+		}
+	}
+	std::cout << (passed ? "all input families scale linearly" : "super-linear scaling found") << std::endl;
+	return passed ? 0 : 1;
+}
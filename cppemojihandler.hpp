@@ -32,10 +32,11 @@ static std::vector<std::unordered_set<Char>> create_emoji_bank(std::unordered_ma
 	return res;
 }
 
-static inline String emoji_chars_from_start(String s, std::vector<std::unordered_set<Char>> bank)
+static inline String emoji_chars_from_start(const String &s, size_t start, const std::vector<std::unordered_set<Char>> &bank)
 {
+	// the characters from s[start] on that could be part of an emoji, at most as many as the longest emoji has
 	String res = u8"";
-	for (int i = 0; i < s.length() && bank[i].count(s[i]); i++)
-		res += s[i];
+	for (size_t i = 0; start + i < s.length() && i < bank.size() && bank[i].count(s[start + i]); i++)
+		res += s[start + i];
 	return res;
 }
\ No newline at end of file
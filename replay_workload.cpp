@@ -0,0 +1,47 @@
+// replays a workload log captured with vader::WorkloadCapture and reports throughput and latency percentiles
+// usage: replay_workload log_file [speed] [repeats]
+// speed: "max" (the default) scores the texts back to back, 1 at the recorded rate, 2 at twice the recorded rate
+#include <iostream>
+#include <string>
+
+#include "WorkloadCapture.hpp"
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " log_file [speed|max] [repeats]" << std::endl;
+		return 2;
+	}
+	std::string log_file = argv[1];
+	double speed = argc > 2 && std::string(argv[2]) != "max" ? std::stod(argv[2]) : 0.0;
+	int repeats = argc > 3 ? std::stoi(argv[3]) : 1;
+
+	vader::SentimentIntensityAnalyzer vader;
+	vader::WorkloadReplay replay(vader);
+	if (!replay.load(log_file))
+	{
+		std::cerr << replay.get_error() << std::endl;
+		return 1;
+	}
+	if (replay.get_records().empty())
+	{
+		std::cerr << log_file << " holds no texts" << std::endl;
+		return 1;
+	}
+	if (replay.get_redaction() != vader::CaptureRedaction::NONE)
+		std::cerr << "note: the log is redacted, its scores differ from the original texts'" << std::endl;
+
+	vader::ReplayReport report = replay.replay(speed, repeats);
+	std::cout << "texts              " << report.texts << std::endl;
+	std::cout << "bytes              " << report.bytes << std::endl;
+	std::cout << "seconds            " << report.seconds << std::endl;
+	std::cout << "texts/s            " << report.texts_per_second << std::endl;
+	std::cout << "MB/s               " << report.mb_per_second << std::endl;
+	std::cout << "latency p50 (us)   " << report.latency_p50 << std::endl;
+	std::cout << "latency p90 (us)   " << report.latency_p90 << std::endl;
+	std::cout << "latency p99 (us)   " << report.latency_p99 << std::endl;
+	std::cout << "latency p99.9 (us) " << report.latency_p999 << std::endl;
+	std::cout << "latency max (us)   " << report.latency_max << std::endl;
+	return 0;
+}
@@ -0,0 +1,28 @@
+// scores every line of a corpus file, resuming an interrupted run if there is a checkpoint
+// usage: score_corpus input_file [output_file] [threads]
+#include <iostream>
+#include <string>
+
+#include "CorpusScorer.hpp"
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " input_file [output_file] [threads]" << std::endl;
+		return 2;
+	}
+	std::string input_file = argv[1];
+	std::string output_file = argc > 2 ? argv[2] : input_file + ".vader";
+	int threads = argc > 3 ? std::stoi(argv[3]) : 0;
+
+	vader::SentimentIntensityAnalyzer vader;
+	vader::CorpusScorer scorer(vader, threads);
+	scorer.set_progress_stream(&std::cerr);
+	if (!scorer.score_file(input_file, output_file))
+	{
+		std::cerr << scorer.get_error() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -5,6 +5,7 @@
 #include "vaderSentiment.hpp"
 #include "SentiText.hpp"
 #include "SentimentIntensityAnalyzer.hpp"
+#include "SentimentAggregator.hpp"
 
 int main()
 {
@@ -85,6 +86,57 @@ int main()
 	}
 	std::cout << "----------------------------------------------------" << std::endl;
 
+	auto same = [](const vader::Sentiment &a, const vader::Sentiment &b) {
+		return a.compound == b.compound && a.neg == b.neg && a.neu == b.neu && a.pos == b.pos;
+	};
+
+	std::cout << " - Check that the other entry points score exactly as polarity_scores does." << std::endl;
+	String long_text;
+	while (long_text.length() < (1 << 18))
+		for (String sentence : sentences)
+			long_text += sentence + u8" ";
+	bool parallel_ok = same(vader.polarity_scores_parallel(long_text, 4), vader.polarity_scores(long_text));
+	std::cout << "  -- polarity_scores_parallel: " << (parallel_ok ? "same" : "DIFFERENT") << std::endl;
+
+	bool segments_ok = true;
+	auto check_segments = [&](const String &sentence) {
+		std::vector<StringView> segments; // split every 5 bytes, wherever that falls
+		for (size_t i = 0; i < sentence.length(); i += 5)
+			segments.push_back(StringView(sentence).substr(i, 5));
+		segments_ok = segments_ok && same(vader.polarity_scores(segments.data(), segments.size()), vader.polarity_scores(sentence));
+	};
+	for (String sentence : sentences)
+		check_segments(sentence);
+	for (String sentence : tricky_sentences)
+		check_segments(sentence);
+	std::cout << "  -- polarity_scores over segments: " << (segments_ok ? "same" : "DIFFERENT") << std::endl;
+
+	bool explained_ok = true;
+	vader::ScoreExplanation explanation;
+	for (String sentence : sentences)
+		explained_ok = explained_ok && same(vader.polarity_scores(sentence, explanation), vader.polarity_scores(sentence));
+	for (String sentence : tricky_sentences)
+		explained_ok = explained_ok && same(vader.polarity_scores(sentence, explanation), vader.polarity_scores(sentence));
+	std::cout << "  -- polarity_scores with an explanation: " << (explained_ok ? "same" : "DIFFERENT") << std::endl;
+
+	// LiteralRules only drops the special case idioms: same score without one, a different one with one
+	bool literal_ok = same(vader.polarity_scores<vader::LiteralRules>(sentences[0]), vader.polarity_scores(sentences[0]))
+		&& !same(vader.polarity_scores<vader::LiteralRules>(tricky_sentences[3]), vader.polarity_scores(tricky_sentences[3]));
+	std::cout << "  -- polarity_scores<LiteralRules> drops only the idioms: " << (literal_ok ? "same" : "DIFFERENT") << std::endl;
+
+	// no buckets is taken as one bucket, and a record with a negative timestamp is not counted
+	vader::SentimentAggregator no_buckets(vader, 60, 0);
+	no_buckets.add(u8"book", 30, sentences[7]);
+	bool no_buckets_ok = no_buckets.window(u8"book", 59).count == 1 && no_buckets.window(u8"book", 60).count == 0;
+	std::cout << "  -- SentimentAggregator with 0 buckets: " << (no_buckets_ok ? "ok" : "WRONG") << std::endl;
+	vader::SentimentAggregator aggregator(vader, 60, 6);
+	aggregator.add(u8"book", -30, sentences[7]);
+	aggregator.add(u8"book", 30, sentences[7]);
+	bool negative_ok = aggregator.window(u8"book", 30).count == 1 && aggregator.window(u8"book", -30).count == 0
+		&& aggregator.heavy_hitters(1)[0].count == 1;
+	std::cout << "  -- SentimentAggregator ignores negative timestamps: " << (negative_ok ? "ok" : "WRONG") << std::endl;
+	std::cout << "----------------------------------------------------" << std::endl;
+
 	std::cin.get();
 
 	return 0;
@@ -27,6 +27,7 @@ Weblogs and Social Media (ICWSM-14). Ann Arbor, MI, June 2014.
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <algorithm>
@@ -104,6 +105,8 @@ inline std::string from_u8string(const String &s)
 }
 #endif
 
+typedef std::basic_string_view<String::value_type> StringView; // a token of a caller's buffer, see SentiText(tokens, punctuation)
+
 
 inline std::vector<std::string> split(std::string s)
 {
@@ -305,4 +308,57 @@ namespace vader
         double pos = 0.0;
         double compound = 0.0;
     };
+
+    struct PunctuationCounts // of the whole text, after emoji substitution (a few emoji descriptions contain '!')
+    {
+        int exclamation_marks = 0;
+        int question_marks = 0;
+    };
+
+    inline PunctuationCounts count_punctuation(StringView text)
+    {
+        PunctuationCounts res;
+        res.exclamation_marks = std::count(text.begin(), text.end(), u8'!');
+        res.question_marks = std::count(text.begin(), text.end(), u8'?');
+        return res;
+    }
+
+    // Rule policies, the template argument of SentimentIntensityAnalyzer::polarity_scores<Rules>. Rules switched off are
+    // compiled out of the scoring loop rather than skipped at runtime. The templates are instantiated in
+    // SentimentIntensityAnalyzer.cpp for the policies below only (VADER_INSTANTIATE_RULES); any other policy, even one
+    // derived from DefaultRules, fails to link unless a line is added there.
+    struct DefaultRules
+    {
+        static constexpr bool emoji = true; // replace emojis with their textual descriptions
+        static constexpr bool caps = true; // ALL CAPS emphasis (allcap_differential, C_INCR)
+        static constexpr bool idioms = true; // special case idioms and booster n-grams (_special_idioms_check)
+        static constexpr bool sift = true; // pos/neu/neg proportions (_sift_sentiment_scores), only compound otherwise
+        static constexpr bool explain = false; // record each token's valence and the rules that changed it (ScoreExplanation)
+    };
+
+    struct CompoundOnlyRules : DefaultRules
+    {
+        static constexpr bool sift = false;
+    };
+
+    struct PlainTextRules : DefaultRules // for emoji free, lowercase only text, where these rules never apply
+    {
+        static constexpr bool emoji = false;
+        static constexpr bool caps = false;
+    };
+
+    struct PlainTextCompoundOnlyRules : PlainTextRules
+    {
+        static constexpr bool sift = false;
+    };
+
+    struct LiteralRules : DefaultRules // idioms taken word by word, e.g. "bad ass" scored as "bad"
+    {
+        static constexpr bool idioms = false;
+    };
+
+    struct ExplainRules : DefaultRules // used by polarity_scores(text, explanation)
+    {
+        static constexpr bool explain = true;
+    };
 }